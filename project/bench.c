@@ -0,0 +1,375 @@
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+/** @brief Bits of sub-bucket index - every power of 2 is split into 2^bits buckets (~1.5% precision) */
+#define HIST_SUB_BITS ( 6 )
+#define HIST_SUB_COUNT ( 1 << HIST_SUB_BITS )
+/** @brief Count of buckets of latency histogram - covers whole `uint64_t` range */
+#define HIST_BUCKETS ( 64 * HIST_SUB_COUNT )
+
+/** @brief Log-linear (HDR-style) histogram of call latencies in nanoseconds */
+typedef struct
+{
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} histogram_t;
+
+/** @brief Results of single benchmark thread */
+typedef struct
+{
+    pthread_t tid;
+    unsigned seed;
+    histogram_t hist;
+    uint64_t written;
+    uint64_t bytes;
+    uint64_t ignored;
+    uint64_t dropped;
+    uint64_t failed;
+} worker_t;
+
+/** @brief Benchmark parameters */
+struct
+{
+    unsigned threads;
+    unsigned long messages;
+    unsigned size;
+    /** @brief Relative weights of MIN, STANDARD and MAX messages */
+    unsigned mix[3];
+    log_lvl_e level;
+    unsigned storm_hz;
+    const char* path;
+    log_config_t config;
+} params = {
+    .threads = 1,
+    .messages = 100000,
+    .size = 64,
+    .mix = { 1, 0, 0 },
+    .level = LOG_LVL_MAX,
+    .storm_hz = 0,
+    .path = NULL,
+};
+
+/** @brief Payload of benchmark messages */
+char* payload;
+/** @brief Whether workers may start - all are released at once */
+atomic_bool start = false;
+/** @brief Whether signal storm should continue */
+atomic_bool storm_run = true;
+/** @brief Count of signals sent by storm thread */
+uint64_t storm_sent = 0;
+
+void usage(const char* _cmd);
+bool parse_mix(const char* _arg);
+void* worker_thread(void* _worker);
+void* storm_thread(void* _);
+void hist_record(histogram_t* _hist, uint64_t _value);
+void hist_merge(histogram_t* _into, const histogram_t* _from);
+uint64_t hist_percentile(const histogram_t* _hist, double _percentile);
+uint64_t now_ns(void);
+
+int main(int argc, char* const argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:s:l:L:m:f:y:S:d:h")) != -1)
+    {
+        errno = 0;
+        switch (opt)
+        {
+        case 't':
+            params.threads = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            params.messages = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            params.size = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            if (!parse_mix(optarg)) { errno = EINVAL; }
+            break;
+        case 'L':
+            if (strcmp(optarg, "min") == 0) { params.level = LOG_LVL_MIN; }
+            else if (strcmp(optarg, "std") == 0) { params.level = LOG_LVL_STANDARD; }
+            else if (strcmp(optarg, "max") == 0) { params.level = LOG_LVL_MAX; }
+            else { errno = EINVAL; }
+            break;
+        case 'm':
+            if (strcmp(optarg, "sync") == 0) { params.config.mode = LOG_MODE_SYNC; }
+            else if (strcmp(optarg, "async") == 0) { params.config.mode = LOG_MODE_ASYNC; }
+            else if (strcmp(optarg, "mmap") == 0) { params.config.mode = LOG_MODE_MMAP; }
+            else { errno = EINVAL; }
+            break;
+        case 'f':
+            if (strcmp(optarg, "text") == 0) { params.config.format = LOG_FORMAT_TEXT; }
+            else if (strcmp(optarg, "binary") == 0) { params.config.format = LOG_FORMAT_BINARY; }
+            else { errno = EINVAL; }
+            break;
+        case 'y':
+            if (strcmp(optarg, "msg") == 0) { params.config.sync = LOG_SYNC_MESSAGE; }
+            else if (strcmp(optarg, "data") == 0) { params.config.sync = LOG_SYNC_DATA; }
+            else if (strcmp(optarg, "count") == 0) { params.config.sync = LOG_SYNC_COUNT; }
+            else if (strcmp(optarg, "time") == 0) { params.config.sync = LOG_SYNC_INTERVAL; }
+            else if (strcmp(optarg, "none") == 0) { params.config.sync = LOG_SYNC_NONE; }
+            else { errno = EINVAL; }
+            break;
+        case 'S':
+            params.storm_hz = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            params.path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (errno != 0)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Invalid value for -%c: %s!\n\n"
+                "\33[0m",
+                opt, optarg);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (params.threads == 0 || params.messages == 0)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Thread and message count must be positive!\n\n"
+            "\33[0m");
+        usage(argv[0]);
+        return 1;
+    }
+
+    payload = (char*)malloc(params.size + 1);
+    worker_t* workers = (worker_t*)calloc(params.threads, sizeof(worker_t));
+    if (payload == NULL || workers == NULL)
+    {
+        fprintf(stderr, "\033[0;31m" "Cannot allocate memory!\n" "\33[0m");
+        return 1;
+    }
+    memset(payload, 'x', params.size);
+    payload[params.size] = '\0';
+
+    log_res_e ret = log_init(params.path, &params.config);
+    if (ret != LOG_RES_SUCCESS)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Cannot initialize logging: error code [%d] (%s)!\n"
+            "\33[0m",
+            ret, strerror(errno));
+        return 1;
+    }
+    log_dispatch_log_level(0, params.level);
+
+    for (unsigned i = 0; i < params.threads; ++i)
+    {
+        workers[i].seed = 0x9E3779B9u * (i + 1);
+        pthread_create(&workers[i].tid, NULL, worker_thread, &workers[i]);
+    }
+    pthread_t storm_tid;
+    if (params.storm_hz) { pthread_create(&storm_tid, NULL, storm_thread, NULL); }
+
+    uint64_t begin = now_ns();
+    atomic_store(&start, true);
+    for (unsigned i = 0; i < params.threads; ++i) { pthread_join(workers[i].tid, NULL); }
+    uint64_t elapsed = now_ns() - begin;
+    atomic_store(&storm_run, false);
+    if (params.storm_hz) { pthread_join(storm_tid, NULL); }
+
+    // Draining of rings (or unmapping) is part of cost of run
+    log_deinit();
+    uint64_t elapsed_drained = now_ns() - begin;
+
+    histogram_t* total = (histogram_t*)calloc(1, sizeof(histogram_t));
+    worker_t sum = { 0 };
+    for (unsigned i = 0; i < params.threads; ++i)
+    {
+        hist_merge(total, &workers[i].hist);
+        sum.written += workers[i].written;
+        sum.bytes += workers[i].bytes;
+        sum.ignored += workers[i].ignored;
+        sum.dropped += workers[i].dropped;
+        sum.failed += workers[i].failed;
+    }
+
+    static const char* mode_names[] = { "sync", "async", "mmap" };
+    static const char* format_names[] = { "text", "binary" };
+    double seconds = (double)elapsed / 1e9;
+    printf("mode %s, format %s, %u threads x %lu messages of %u bytes, mix %u:%u:%u, storm %u Hz\n",
+        mode_names[params.config.mode], format_names[params.config.format],
+        params.threads, params.messages, params.size,
+        params.mix[0], params.mix[1], params.mix[2], params.storm_hz);
+    printf("written  %" PRIu64 ", ignored %" PRIu64 ", dropped %" PRIu64 ", failed %" PRIu64 "\n",
+        sum.written, sum.ignored, sum.dropped, sum.failed);
+    printf("elapsed  %.3f s (%.3f s with drain)\n", seconds, (double)elapsed_drained / 1e9);
+    printf("rate     %.0f calls/s, %.0f messages/s, %.2f MiB/s\n",
+        (double)total->total / seconds, (double)sum.written / seconds,
+        (double)sum.bytes / seconds / (1024.0 * 1024.0));
+    printf("latency  p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, p99.9 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+        hist_percentile(total, 50.0), hist_percentile(total, 99.0),
+        hist_percentile(total, 99.9), total->max);
+    if (params.storm_hz) { printf("signals  %" PRIu64 "\n", storm_sent); }
+
+    free(total);
+    free(workers);
+    free(payload);
+    return 0;
+}
+
+void usage(const char* _cmd)
+{
+    fprintf(stderr, "Usage %s [options]\n", _cmd);
+    fprintf(stderr, "------------------------\n");
+    fprintf(stderr,
+        "Options are:\n"
+        "    -t <threads> (default 1)\n"
+        "    -n <messages per thread> (default 100000)\n"
+        "    -s <message size in bytes> (default 64)\n"
+        "    -l <min>:<std>:<max> weights of message levels (default 1:0:0)\n"
+        "    -L min|std|max logging level during run (default max)\n"
+        "    -m sync|async|mmap writing mode (default sync)\n"
+        "    -f text|binary LOG format (default text)\n"
+        "    -y msg|data|count|time|none durability policy (default msg)\n"
+        "    -S <Hz> rate of SIGLOG/SIGDUMP storm during run (default 0 - off)\n"
+        "    -d <path> directory of LOG and DUMP files (default .)\n"
+    );
+}
+
+bool parse_mix(const char* _arg)
+{
+    char* end;
+    for (int i = 0; i < 3; ++i)
+    {
+        params.mix[i] = (unsigned)strtoul(_arg, &end, 10);
+        if (end == _arg || (i < 2 && *end != ':') || (i == 2 && *end != '\0')) { return false; }
+        _arg = end + 1;
+    }
+    return params.mix[0] + params.mix[1] + params.mix[2] > 0;
+}
+
+void* worker_thread(void* _worker)
+{
+    worker_t* worker = (worker_t*)_worker;
+    unsigned weight_sum = params.mix[0] + params.mix[1] + params.mix[2];
+    while (!atomic_load(&start)) { }
+
+    for (unsigned long i = 0; i < params.messages; ++i)
+    {
+        // Pick level by weights (xorshift)
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 17;
+        worker->seed ^= worker->seed << 5;
+        unsigned pick = worker->seed % weight_sum;
+        log_lvl_e lvl = pick < params.mix[0] ? LOG_LVL_MIN
+            : pick < params.mix[0] + params.mix[1] ? LOG_LVL_STANDARD : LOG_LVL_MAX;
+
+        uint64_t begin = now_ns();
+        log_res_e ret = log_printf(lvl, "%lu %s", i, payload);
+        hist_record(&worker->hist, now_ns() - begin);
+
+        switch (ret)
+        {
+        case LOG_RES_SUCCESS:
+            ++worker->written;
+            worker->bytes += params.size;
+            break;
+        case LOG_RES_IGNORED:
+        case LOG_RES_OFF:
+            ++worker->ignored;
+            break;
+        case LOG_RES_DROPPED:
+            ++worker->dropped;
+            break;
+        default:
+            ++worker->failed;
+            break;
+        }
+    }
+    return NULL;
+}
+
+void* storm_thread(void* _)
+{
+    struct timespec period = {
+        .tv_sec = 0,
+        .tv_nsec = 1000000000L / params.storm_hz,
+    };
+    if (params.storm_hz == 1) { period = (struct timespec){ .tv_sec = 1, .tv_nsec = 0 }; }
+    while (!atomic_load(&start)) { }
+
+    // Level is re-set to its current value, so that only cost of signal handling is measured
+    while (atomic_load(&storm_run))
+    {
+        if (storm_sent % 2 == 0) { log_dispatch_log_level(0, params.level); }
+        else { log_dispatch_log_dump(0, LOG_DUMP_LVL_NORMAL); }
+        ++storm_sent;
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+void hist_record(histogram_t* _hist, uint64_t _value)
+{
+    // Values below 2^HIST_SUB_BITS are exact, above them bucket width doubles with every power of 2
+    size_t idx;
+    if (_value < HIST_SUB_COUNT) { idx = (size_t)_value; }
+    else
+    {
+        int exp = 63 - __builtin_clzll(_value) - HIST_SUB_BITS;
+        idx = (size_t)(exp + 1) * HIST_SUB_COUNT + (size_t)((_value >> exp) - HIST_SUB_COUNT);
+    }
+    ++_hist->counts[idx];
+    ++_hist->total;
+    if (_value > _hist->max) { _hist->max = _value; }
+}
+
+void hist_merge(histogram_t* _into, const histogram_t* _from)
+{
+    for (size_t i = 0; i < HIST_BUCKETS; ++i) { _into->counts[i] += _from->counts[i]; }
+    _into->total += _from->total;
+    if (_from->max > _into->max) { _into->max = _from->max; }
+}
+
+uint64_t hist_percentile(const histogram_t* _hist, double _percentile)
+{
+    uint64_t rank = (uint64_t)((double)_hist->total * _percentile / 100.0);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; ++i)
+    {
+        seen += _hist->counts[i];
+        if (seen > rank || (seen == _hist->total && seen > 0))
+        {
+            // Report upper bound of bucket
+            if (i < HIST_SUB_COUNT) { return (uint64_t)i; }
+            size_t exp = i / HIST_SUB_COUNT - 1;
+            uint64_t sub = (uint64_t)(i % HIST_SUB_COUNT) + HIST_SUB_COUNT;
+            uint64_t bound = ((sub + 1) << exp) - 1;
+            return bound < _hist->max ? bound : _hist->max;
+        }
+    }
+    return _hist->max;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
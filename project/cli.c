@@ -5,10 +5,48 @@
 #include <unistd.h>
 #include <signal.h>
 #include <errno.h>
+#include <dirent.h>
 
 #include "logger.h"
 
+/** @brief Command applied to every target */
+typedef enum
+{
+    CMD_LOG_LVL,
+    CMD_DUMP_ORD,
+    CMD_SYNC,
+    CMD_ROTATE,
+    CMD_TAIL,
+    CMD_STATS,
+} cmd_e;
+
+/** @brief Parsed command with its argument */
+typedef struct
+{
+    cmd_e cmd;
+    log_category_t cat;
+    log_lvl_e lvl;
+    log_dump_lvl_e dump_lvl;
+    log_sync_e sync;
+    unsigned param;
+    size_t bytes;
+    unsigned interval_s;
+} cmd_t;
+
+/** @brief Set of target processes, without repetitions */
+typedef struct
+{
+    pid_t* pids;
+    size_t count;
+    size_t cap;
+} targets_t;
+
 void usage(const char* _cmd);
+log_res_e set_level(pid_t _pid, log_category_t _cat, log_lvl_e _lvl);
+log_res_e set_sync(pid_t _pid, log_sync_e _sync, unsigned _param);
+log_res_e run(const cmd_t* _cmd, pid_t _pid);
+bool add_pid(targets_t* _targets, long _pid);
+bool add_target(targets_t* _targets, const char* _target);
 
 int main(int argc, char const *argv[])
 {
@@ -22,33 +60,78 @@ int main(int argc, char const *argv[])
         return 1;
     }
 
-    long pid;
-    errno = 0;
-    pid = strtol(argv[argc - 1], NULL, 10);
-    if (errno != 0 || pid == 0)
+    // Parse command - its targets follow its argument
+    cmd_t cmd = { 0 };
+    int first = 3;
+    if (strcmp(argv[1], "log_lvl") == 0)
     {
-        fprintf(stderr,
-            "\033[0;31m"
-            "Invalid pid number: %s!\n\n"
-            "\33[0m",
-            argv[argc - 1]);
-        usage(argv[0]);
-        return 1;
+        if (argc < 4)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Argument number too low!\n\n"
+                "\33[0m");
+            usage(argv[0]);
+            return 1;
+        }
+
+        // Split "<level>[:<category>]"
+        char lvl_name[8] = { 0 };
+        long category = -1;
+        const char* colon = strchr(argv[2], ':');
+        size_t lvl_len = colon != NULL ? (size_t)(colon - argv[2]) : strlen(argv[2]);
+        if (lvl_len < sizeof(lvl_name)) { memcpy(lvl_name, argv[2], lvl_len); }
+        if (colon != NULL)
+        {
+            errno = 0;
+            category = strtol(colon + 1, NULL, 10);
+            if (errno != 0 || category < 0 || category >= LOG_MAX_CATEGORIES)
+            {
+                fprintf(stderr,
+                    "\033[0;31m"
+                    "Invalid category for log_lvl: %s\n\n"
+                    "\33[0m",
+                    colon + 1);
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        log_lvl_e lvl;
+        if (strcmp(lvl_name, "off") == 0) { lvl = LOG_LVL_OFF; }
+        else if (strcmp(lvl_name, "min") == 0) { lvl = LOG_LVL_MIN; }
+        else if (strcmp(lvl_name, "std") == 0) { lvl = LOG_LVL_STANDARD; }
+        else if (strcmp(lvl_name, "max") == 0) { lvl = LOG_LVL_MAX; }
+        else
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Unknown value for log_lvl: %s\n\n"
+                "\33[0m",
+                argv[2]);
+            usage(argv[0]);
+            return 1;
+        }
+
+        cmd.cmd = CMD_LOG_LVL;
+        cmd.cat = category < 0 ? LOG_MAX_CATEGORIES : (log_category_t)category;
+        cmd.lvl = lvl;
     }
-    char cmd[128] = { 0 };
-    sprintf(cmd, "ls /proc/%ld > /dev/null 2>&1", pid);
-    if (system(cmd) != 0)
+    else if (strcmp(argv[1], "dump_ord") == 0)
     {
-        fprintf(stderr, "\033[0;31m" 
-            "No process with pid number: %ld!\n\n"
-            "\33[0m",
-            pid);
-        usage(argv[0]);
-        return 1;
+        // Level can be omitted - then first target follows command
+        cmd.cmd = CMD_DUMP_ORD;
+        if (strcmp(argv[2], "norm") == 0) { cmd.dump_lvl = LOG_DUMP_LVL_NORMAL; }
+        else if (strcmp(argv[2], "detl") == 0) { cmd.dump_lvl = LOG_DUMP_LVL_DETAIL; }
+        else if (strcmp(argv[2], "extd") == 0) { cmd.dump_lvl = LOG_DUMP_LVL_EXTENDED; }
+        else if (strcmp(argv[2], "full") == 0) { cmd.dump_lvl = LOG_DUMP_LVL_FULL; }
+        else
+        {
+            cmd.dump_lvl = LOG_DUMP_LVL_NORMAL;
+            first = 2;
+        }
     }
-
-
-    if (strcmp(argv[1], "log_lvl") == 0)
+    else if (strcmp(argv[1], "sync") == 0)
     {
         if (argc < 4)
         {
@@ -60,87 +143,236 @@ int main(int argc, char const *argv[])
             return 1;
         }
 
-        if (strcmp(argv[2], "off") == 0)
+        // Split "<policy>[:<param>]"
+        char policy[8] = { 0 };
+        unsigned long param = 0;
+        const char* colon = strchr(argv[2], ':');
+        size_t policy_len = colon != NULL ? (size_t)(colon - argv[2]) : strlen(argv[2]);
+        if (policy_len < sizeof(policy)) { memcpy(policy, argv[2], policy_len); }
+        if (colon != NULL)
         {
-            log_dispatch_log_level(pid, LOG_LVL_OFF);
-            return 0;
+            errno = 0;
+            param = strtoul(colon + 1, NULL, 10);
+            if (errno != 0 || param == 0 || param > 0x7FFFFFF)
+            {
+                fprintf(stderr,
+                    "\033[0;31m"
+                    "Invalid parameter for sync: %s\n\n"
+                    "\33[0m",
+                    colon + 1);
+                usage(argv[0]);
+                return 1;
+            }
         }
-        if (strcmp(argv[2], "min") == 0)
+
+        cmd.cmd = CMD_SYNC;
+        cmd.param = (unsigned)param;
+        if (strcmp(policy, "msg") == 0) { cmd.sync = LOG_SYNC_MESSAGE; cmd.param = 0; }
+        else if (strcmp(policy, "data") == 0) { cmd.sync = LOG_SYNC_DATA; cmd.param = 0; }
+        else if (strcmp(policy, "count") == 0) { cmd.sync = LOG_SYNC_COUNT; }
+        else if (strcmp(policy, "time") == 0) { cmd.sync = LOG_SYNC_INTERVAL; }
+        else if (strcmp(policy, "none") == 0) { cmd.sync = LOG_SYNC_NONE; cmd.param = 0; }
+        else
         {
-            log_dispatch_log_level(pid, LOG_LVL_MIN);
-            return 0;
+            fprintf(stderr,
+                "\033[0;31m"
+                "Unknown value for sync: %s\n\n"
+                "\33[0m",
+                argv[2]);
+            usage(argv[0]);
+            return 1;
         }
-        if (strcmp(argv[2], "std") == 0)
+    }
+    else if (strcmp(argv[1], "rotate") == 0)
+    {
+        if (argc < 4)
         {
-            log_dispatch_log_level(pid, LOG_LVL_STANDARD);
-            return 0;
+            fprintf(stderr,
+                "\033[0;31m"
+                "Argument number too low!\n\n"
+                "\33[0m");
+            usage(argv[0]);
+            return 1;
         }
-        if (strcmp(argv[2], "max") == 0)
+
+        // Split "<bytes>[:<seconds>]"
+        char* end;
+        errno = 0;
+        unsigned long long bytes = strtoull(argv[2], &end, 10);
+        unsigned long interval_s = 0;
+        if (errno == 0 && *end == ':') { interval_s = strtoul(end + 1, &end, 10); }
+        if (errno != 0 || *end != '\0' || interval_s > 0xFFFFFFFF)
         {
-            log_dispatch_log_level(pid, LOG_LVL_MAX);
-            return 0;
+            fprintf(stderr,
+                "\033[0;31m"
+                "Invalid value for rotate: %s\n\n"
+                "\33[0m",
+                argv[2]);
+            usage(argv[0]);
+            return 1;
         }
 
+        cmd.cmd = CMD_ROTATE;
+        cmd.bytes = (size_t)bytes;
+        cmd.interval_s = (unsigned)interval_s;
+    }
+    else if (strcmp(argv[1], "tail") == 0)
+    {
+        cmd.cmd = CMD_TAIL;
+        first = 2;
+    }
+    else if (strcmp(argv[1], "stats") == 0)
+    {
+        cmd.cmd = CMD_STATS;
+        first = 2;
+    }
+    else
+    {
         fprintf(stderr,
             "\033[0;31m"
-            "Unknown value for log_lvl: %s\n\n"
+            "Unknown command: %s!\n\n"
             "\33[0m",
-            argv[2]);
+            argv[1]);
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Resolve targets - PIDs, PID files and process names
+    targets_t targets = { 0 };
+    if (first >= argc)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Argument number too low!\n\n"
+            "\33[0m");
         usage(argv[0]);
         return 1;
     }
-    if (strcmp(argv[1], "dump_ord") == 0)
+    for (int i = first; i < argc; ++i)
+    {
+        if (!add_target(&targets, argv[i]))
+        {
+            usage(argv[0]);
+            free(targets.pids);
+            return 1;
+        }
+    }
+    if (targets.count == 0)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "No process matches targets!\n\n"
+            "\33[0m");
+        free(targets.pids);
+        return 1;
+    }
+
+    if (cmd.cmd == CMD_TAIL)
     {
-        if (argc == 3 || strcmp(argv[2], "norm") == 0)
+        if (targets.count > 1)
         {
-            log_dispatch_log_dump(pid, LOG_DUMP_LVL_NORMAL);
-            return 0;
+            fprintf(stderr,
+                "\033[0;31m"
+                "Tail streams single process, but %zu match!\n\n"
+                "\33[0m",
+                targets.count);
+            free(targets.pids);
+            return 1;
         }
-        if (strcmp(argv[2], "detl") == 0)
+        pid_t pid = targets.pids[0];
+        free(targets.pids);
+
+        log_tail_t* tail;
+        if (log_tail_open(pid, 10, &tail) != LOG_RES_SUCCESS)
         {
-            log_dispatch_log_dump(pid, LOG_DUMP_LVL_DETAIL);
-            return 0;
+            fprintf(stderr,
+                "\033[0;31m"
+                "Process %ld has no tail ring!\n\n"
+                "\33[0m",
+                (long)pid);
+            return 1;
         }
-        if (strcmp(argv[2], "extd") == 0)
+
+        // Stream until process exits - stopped with SIGINT
+        char record[1024];
+        size_t len;
+        unsigned long long missed;
+        while (true)
         {
-            log_dispatch_log_dump(pid, LOG_DUMP_LVL_EXTENDED);
-            return 0;
+            log_tail_next(tail, record, sizeof(record), &len, &missed);
+            if (missed)
+            {
+                fflush(stdout);
+                fprintf(stderr,
+                    "\033[0;31m"
+                    "... %llu records missed ...\n"
+                    "\33[0m",
+                    missed);
+            }
+            if (len)
+            {
+                fwrite(record, 1, len, stdout);
+                if (record[len - 1] != '\n') { fputc('\n', stdout); }
+                continue;
+            }
+            fflush(stdout);
+            if (kill(pid, 0) != 0 && errno == ESRCH) { break; }
+            usleep(10000);
         }
-        if (strcmp(argv[2], "full") == 0)
+        log_tail_close(tail);
+        return 0;
+    }
+
+    // Dispatch to every target, reporting result of each
+    int failed = 0;
+    for (size_t i = 0; i < targets.count; ++i)
+    {
+        pid_t pid = targets.pids[i];
+        const char* error = NULL;
+        if (kill(pid, 0) != 0) { error = errno == EPERM ? "not permitted" : "no such process"; }
+        else
         {
-            log_dispatch_log_dump(pid, LOG_DUMP_LVL_FULL);
-            return 0;
+            switch (run(&cmd, pid))
+            {
+            case LOG_RES_SUCCESS: break;
+            case LOG_RES_ERROR_ARG: error = "invalid argument"; break;
+            case LOG_RES_ERROR_FILE: error = "no control block"; break;
+            case LOG_RES_ERROR_SYNC: error = "cannot send signal"; break;
+            default: error = "failed"; break;
+            }
         }
 
-        fprintf(stderr,
-            "\033[0;31m"
-            "Unknown value for dump_ord: %s\n\n"
-            "\33[0m", 
-            argv[2]);
-        usage(argv[0]);
-        return 1;
+        if (error == NULL) { printf("%ld: OK\n", (long)pid); }
+        else
+        {
+            ++failed;
+            fprintf(stderr,
+                "\033[0;31m"
+                "%ld: %s\n"
+                "\33[0m",
+                (long)pid, error);
+        }
     }
-    fprintf(stderr,
-        "\033[0;31m"
-        "Unknown command: %s!\n\n"
-        "\33[0m",
-        argv[1]);
-    usage(argv[0]);
+    free(targets.pids);
 
-    return 1;
+    return failed ? 1 : 0;
 }
 
 void usage(const char* _cmd)
 {
-    fprintf(stderr, "Usage %s <command> <arg> <pid>\n", _cmd);
+    fprintf(stderr, "Usage %s <command> <arg> <target>...\n", _cmd);
     fprintf(stderr, "------------------------\n");
     fprintf(stderr, 
         "Commands are:\n"
         "    log_lvl\n"
         "    dump_ord\n"
+        "    sync\n"
+        "    rotate\n"
+        "    tail (no args - streams records of process from shared memory)\n"
+        "    stats (no args - writes snapshot of logger counters to .STATS file)\n"
     );
     fprintf(stderr, 
-        "For log_lvl, args are:\n"
+        "For log_lvl, args are (optionally followed by :<category id>):\n"
         "    off\n"
         "    min\n"
         "    std\n"
@@ -153,4 +385,178 @@ void usage(const char* _cmd)
         "    extd\n"
         "    full\n"
     );
+    fprintf(stderr, 
+        "For sync, args are:\n"
+        "    msg (fsync after every message)\n"
+        "    data (fdatasync after every message)\n"
+        "    count[:N] (fsync after every N messages)\n"
+        "    time[:MS] (fsync at most every MS milliseconds)\n"
+        "    none\n"
+    );
+    fprintf(stderr, 
+        "For rotate, args are:\n"
+        "    BYTES[:SECONDS] (start new LOG file after BYTES or SECONDS, 0 - never)\n"
+    );
+    fprintf(stderr, 
+        "Targets are (tail accepts single process):\n"
+        "    PID\n"
+        "    @FILE (PID file - one PID per line)\n"
+        "    =NAME (every process of given name, as in /proc/<pid>/comm)\n"
+    );
+}
+
+log_res_e set_level(pid_t _pid, log_category_t _cat, log_lvl_e _lvl)
+{
+    // Processes without control block are still reached by signal
+    log_control_t* ctl;
+    if (log_control_open(_pid, &ctl) != LOG_RES_SUCCESS)
+    {
+        if (_cat == LOG_MAX_CATEGORIES) { return log_dispatch_log_level(_pid, _lvl); }
+        return log_dispatch_category_level(_pid, _cat, _lvl);
+    }
+    log_res_e ret = log_control_level(ctl, _cat, _lvl);
+    log_control_close(ctl);
+    return ret;
+}
+
+log_res_e set_sync(pid_t _pid, log_sync_e _sync, unsigned _param)
+{
+    log_control_t* ctl;
+    if (log_control_open(_pid, &ctl) != LOG_RES_SUCCESS)
+    {
+        return log_dispatch_sync_policy(_pid, _sync, _param);
+    }
+    log_res_e ret = log_control_sync(ctl, _sync, _param);
+    log_control_close(ctl);
+    return ret;
+}
+
+log_res_e run(const cmd_t* _cmd, pid_t _pid)
+{
+    switch (_cmd->cmd)
+    {
+    case CMD_LOG_LVL: return set_level(_pid, _cmd->cat, _cmd->lvl);
+    case CMD_DUMP_ORD: return log_dispatch_log_dump(_pid, _cmd->dump_lvl);
+    case CMD_SYNC: return set_sync(_pid, _cmd->sync, _cmd->param);
+    case CMD_STATS: return log_dispatch_stats(_pid);
+    case CMD_ROTATE:
+    {
+        // Rotation settings do not fit in signal payload - control block is required
+        log_control_t* ctl;
+        if (log_control_open(_pid, &ctl) != LOG_RES_SUCCESS) { return LOG_RES_ERROR_FILE; }
+        log_control_rotation(ctl, _cmd->bytes, _cmd->interval_s);
+        log_control_close(ctl);
+        return LOG_RES_SUCCESS;
+    }
+    default: return LOG_RES_ERROR_ARG;
+    }
+}
+
+bool add_pid(targets_t* _targets, long _pid)
+{
+    if (_pid <= 0 || _pid != (pid_t)_pid) { return false; }
+    for (size_t i = 0; i < _targets->count; ++i)
+    {
+        if (_targets->pids[i] == _pid) { return true; }
+    }
+    if (_targets->count == _targets->cap)
+    {
+        size_t cap = _targets->cap ? _targets->cap * 2 : 64;
+        pid_t* pids = realloc(_targets->pids, cap * sizeof(pid_t));
+        if (pids == NULL) { return false; }
+        _targets->pids = pids;
+        _targets->cap = cap;
+    }
+    _targets->pids[_targets->count++] = (pid_t)_pid;
+    return true;
+}
+
+bool add_target(targets_t* _targets, const char* _target)
+{
+    // PID file - one PID per line
+    if (_target[0] == '@')
+    {
+        FILE* file = fopen(_target + 1, "r");
+        if (file == NULL)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Cannot open PID file: %s!\n\n"
+                "\33[0m",
+                _target + 1);
+            return false;
+        }
+        char line[32];
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), file) != NULL)
+        {
+            char* end;
+            errno = 0;
+            long pid = strtol(line, &end, 10);
+            if (end == line) { continue; }
+            ok = errno == 0 && add_pid(_targets, pid);
+        }
+        fclose(file);
+        if (!ok)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Invalid pid number in PID file: %s!\n\n"
+                "\33[0m",
+                _target + 1);
+        }
+        return ok;
+    }
+
+    // Process name - matched against names of all processes, except this one
+    if (_target[0] == '=')
+    {
+        DIR* proc = opendir("/proc");
+        if (proc == NULL)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Cannot list processes!\n\n"
+                "\33[0m");
+            return false;
+        }
+        const char* name = _target + 1;
+        size_t name_len = strlen(name);
+        // (names are truncated by kernel)
+        if (name_len > 15) { name_len = 15; }
+        pid_t self = getpid();
+        struct dirent* entry;
+        while ((entry = readdir(proc)) != NULL)
+        {
+            char* end;
+            long pid = strtol(entry->d_name, &end, 10);
+            if (*end != '\0' || pid <= 0 || pid == self) { continue; }
+
+            char path[64];
+            char comm[32];
+            snprintf(path, sizeof(path), "/proc/%ld/comm", pid);
+            FILE* file = fopen(path, "r");
+            if (file == NULL) { continue; }
+            size_t len = fread(comm, 1, sizeof(comm) - 1, file);
+            fclose(file);
+            if (len > 0 && comm[len - 1] == '\n') { --len; }
+            if (len == name_len && memcmp(comm, name, len) == 0) { add_pid(_targets, pid); }
+        }
+        closedir(proc);
+        return true;
+    }
+
+    char* end;
+    errno = 0;
+    long pid = strtol(_target, &end, 10);
+    if (errno != 0 || *end != '\0' || !add_pid(_targets, pid))
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Invalid pid number: %s!\n\n"
+            "\33[0m",
+            _target);
+        return false;
+    }
+    return true;
 }
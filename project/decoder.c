@@ -0,0 +1,87 @@
+#include <stdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+void usage(const char* _cmd);
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Argument number too low!\n\n"
+            "\33[0m");
+        usage(argv[0]);
+        return 1;
+    }
+
+    int in_fd = open(argv[1], O_RDONLY);
+    if (in_fd < 0)
+    {
+        fprintf(stderr,
+            "\033[0;31m"
+            "Cannot open file: %s (%s)!\n\n"
+            "\33[0m",
+            argv[1], strerror(errno));
+        usage(argv[0]);
+        return 1;
+    }
+
+    int out_fd = STDOUT_FILENO;
+    if (argc >= 3)
+    {
+        out_fd = open(argv[2], O_CREAT | O_WRONLY | O_TRUNC,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+        if (out_fd < 0)
+        {
+            fprintf(stderr,
+                "\033[0;31m"
+                "Cannot create file: %s (%s)!\n\n"
+                "\33[0m",
+                argv[2], strerror(errno));
+            close(in_fd);
+            return 1;
+        }
+    }
+
+    log_res_e ret = log_decode(in_fd, out_fd);
+    close(in_fd);
+    if (out_fd != STDOUT_FILENO) { close(out_fd); }
+
+    switch (ret)
+    {
+    case LOG_RES_SUCCESS:
+        return 0;
+    case LOG_RES_ERROR_ARG:
+        fprintf(stderr,
+            "\033[0;31m"
+            "Not a binary LOG file: %s!\n\n"
+            "\33[0m",
+            argv[1]);
+        usage(argv[0]);
+        return 1;
+    default:
+        fprintf(stderr,
+            "\033[0;31m"
+            "Failed to decode file: %s!\n"
+            "\33[0m",
+            argv[1]);
+        return 1;
+    }
+}
+
+void usage(const char* _cmd)
+{
+    fprintf(stderr, "Usage %s <binary LOG file> [output file]\n", _cmd);
+    fprintf(stderr, "------------------------\n");
+    fprintf(stderr,
+        "Renders LOG file written with LOG_FORMAT_BINARY as text LOG file.\n"
+        "If output file is omitted, text is written to standard output.\n"
+    );
+}
@@ -1,5 +1,9 @@
+#include <ctype.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,21 +12,588 @@
 #include <stdbool.h>
 
 #include <dirent.h>
+#include <execinfo.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <mqueue.h>
+#include <poll.h>
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/vfs.h>
+#include <sys/mman.h>
 #include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#ifdef LOG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #include "logger.h"
 
 /** @brief Signal used for LOG level change */
 #define SIGLOG ( SIGRTMIN )
 /** @brief Signal used for DUMP ordering */
 #define SIGDUMP ( SIGRTMIN + 1 )
+/** @brief Signal used for durability policy change */
+#define SIGSYNC ( SIGRTMIN + 2 )
+/** @brief Signal used for ordering snapshot of self-instrumentation counters */
+#define SIGSTAT ( SIGRTMIN + 3 )
+/** @brief Signal used as doorbell after control block was changed */
+#define SIGCTL ( SIGRTMIN + 4 )
+
+/** @brief Default capacity of per-thread ring in `LOG_MODE_ASYNC` */
+#define LOG_DEFAULT_RING_SIZE ( 64 * 1024 )
+/** @brief Smallest allowed capacity of per-thread ring in `LOG_MODE_ASYNC` */
+#define LOG_MIN_RING_SIZE ( 4 * 1024 )
+/** @brief Default maximum time between flusher thread passes */
+#define LOG_DEFAULT_FLUSH_INTERVAL_MS ( 10 )
+/** @brief Default parameter of `LOG_SYNC_COUNT` policy (messages) */
+#define LOG_DEFAULT_SYNC_COUNT ( 64 )
+/** @brief Default parameter of `LOG_SYNC_INTERVAL` policy (milliseconds) */
+#define LOG_DEFAULT_SYNC_INTERVAL_MS ( 1000 )
+/** @brief Bits of packed durability policy used by `log_sync_e` - rest holds parameter */
+#define LOG_SYNC_POLICY_BITS ( 4 )
+/** @brief Largest parameter that fits in packed durability policy */
+#define LOG_SYNC_PARAM_MAX ( (unsigned)INT_MAX >> LOG_SYNC_POLICY_BITS )
+/** @brief Size of per-thread buffer that records are assembled in - longer ones use heap */
+#define LOG_TLS_RECORD_SIZE ( 1024 )
+/** @brief Default maximum size of single record */
+#define LOG_DEFAULT_MAX_RECORD ( 64 * 1024 )
+/** @brief Smallest allowed maximum size of single record */
+#define LOG_MIN_MAX_RECORD ( 128 )
+/** @brief Marker placed at end of truncated record */
+#define LOG_TRUNCATED_MARKER " [TRUNCATED]"
+/** @brief Number of `iovec`s gathered by flusher thread into single `writev`
+ *         (well below `IOV_MAX` of Linux) */
+#define LOG_FLUSH_IOV_BATCH ( 64 )
+/** @brief Default size of LOG file chunk mapped at once in `LOG_MODE_MMAP` */
+#define LOG_DEFAULT_MMAP_CHUNK ( 4 * 1024 * 1024 )
+/** @brief Maximum count of LOG file chunks in `LOG_MODE_MMAP` */
+#define LOG_MMAP_MAX_CHUNKS ( 16384 )
+/** @brief Maximum sequence number appended to name of file created within same second */
+#define LOG_MAX_NAME_SEQ ( 1000 )
+/** @brief Size of buffer used to copy rotated LOG file during compression */
+#define LOG_COMPRESS_BUFFER ( 64 * 1024 )
+/** @brief Size of buffer used to read `/proc` files and to write DUMP file */
+#define LOG_DUMP_BUFFER ( 64 * 1024 )
+/** @brief Size of alternate signal stack that fatal signals are handled on */
+#define LOG_CRASH_STACK_SIZE ( 64 * 1024 )
+/** @brief Count of fatal signals caught by crash handler */
+#define LOG_CRASH_SIGNALS ( 5 )
+/** @brief Maximum count of frames in backtrace of crash DUMP */
+#define LOG_CRASH_FRAMES ( 64 )
+/** @brief Count of submission queue entries of io_uring - batch is write and sync */
+#define LOG_URING_ENTRIES ( 4 )
+/** @brief Log2 of count of per-thread rate limit slots - call sites are hashed into them */
+#define LOG_RATE_SLOTS_BITS ( 6 )
+/** @brief Time after which run of repeated messages is reported even if it continues */
+#define LOG_REPEAT_WINDOW_NS ( 1000000000ULL )
+/** @brief Interval [ms] in which DUMP thread reports closed windows of rate limit and collapsing */
+#define LOG_RATE_SWEEP_MS ( 250 )
+/** @brief Minimum size of per-thread flight recorder ring */
+#define LOG_MIN_FLIGHT_SIZE ( 4 * 1024 )
+/** @brief Minimum time between flight DUMPs ordered by `LOG_LVL_MIN` messages */
+#define LOG_FLIGHT_INTERVAL_NS ( 1000000000ULL )
+/** @brief Maximum count of numeric `/proc/[PID]/smaps` counters shown in DUMP */
+#define LOG_DUMP_MAX_FIELDS ( 32 )
+/** @brief Maximum count of registered DUMP providers */
+#define LOG_DUMP_MAX_PROVIDERS ( 32 )
+/** @brief Maximum length of name of DUMP provider */
+#define LOG_DUMP_NAME_SIZE ( 64 )
+/** @brief Default time after which output of DUMP provider is abandoned */
+#define LOG_DUMP_DEFAULT_TIMEOUT_MS ( 100 )
+/** @brief Maximum size of section written by single DUMP provider */
+#define LOG_DUMP_PROVIDER_MAX ( 1024 * 1024 )
+/** @brief Capacity of DUMP order queue (power of 2) */
+#define LOG_DUMP_QUEUE_SIZE ( 64 )
+/** @brief Bits of SIGDUMP payload holding `log_dump_lvl_e` - rest holds `log_dump_section_e` */
+#define LOG_DUMP_LVL_BITS ( 8 )
+/** @brief Count of distinct DUMP orders (level and sections) that can be pending at once,
+ *         including STATS and control block orders */
+#define LOG_DUMP_KINDS ( 4 * 8 + 2 )
+/** @brief Kind of STATS order - follows all kinds of DUMP orders */
+#define LOG_STATS_KIND ( 4 * 8 )
+/** @brief Kind of order reporting change of control block */
+#define LOG_CONTROL_KIND ( 4 * 8 + 1 )
+/** @brief Name of POSIX shared memory holding control block of process */
+#define LOG_CONTROL_NAME "/scr_log_pid%" PRIdMAX
+/** @brief Magic bytes opening control block, written once it is filled */
+#define LOG_CONTROL_MAGIC "SCRCTL01"
+/** @brief Version of control block layout */
+#define LOG_CONTROL_VERSION ( 1 )
+/** @brief Name of POSIX shared memory holding tail ring of process */
+#define LOG_TAIL_NAME "/scr_tail_pid%" PRIdMAX
+/** @brief Magic bytes opening tail ring, written once it is filled */
+#define LOG_TAIL_MAGIC "SCRTAIL1"
+/** @brief Version of tail ring layout */
+#define LOG_TAIL_VERSION ( 1 )
+/** @brief Size of tail ring slot, including its header */
+#define LOG_TAIL_SLOT_SIZE ( 512 )
+/** @brief Smallest count of tail ring slots */
+#define LOG_TAIL_MIN_RECORDS ( 16 )
+/** @brief Largest count of tail ring slots */
+#define LOG_TAIL_MAX_RECORDS ( 1024 * 1024 )
+/** @brief Time after which reader skips record, that writer did not finish,
+ *         if later records are already published */
+#define LOG_TAIL_STALL_MS ( 100 )
+/** @brief Maximum length of name of log category, including null-string-terminator */
+#define LOG_CATEGORY_NAME_SIZE ( 32 )
+/** @brief Maximum length of name of logger instance, including null-string-terminator */
+#define LOG_INSTANCE_NAME_SIZE ( 16 )
+/** @brief Bits of SIGLOG payload holding `log_lvl_e` - rest holds category identifier + 1 */
+#define LOG_LVL_BITS ( 8 )
+/** @brief Space kept free at end of structured record for its closing part */
+#define LOG_KV_TRAILER ( 48 )
+/** @brief Magic bytes opening binary LOG file */
+#define LOG_BINARY_MAGIC "SCRBLOG1"
+/** @brief Version of binary LOG file layout */
+#define LOG_BINARY_VERSION ( 1 )
+/** @brief Capacity of format string registry used in `LOG_FORMAT_BINARY` */
+#define LOG_FMT_TABLE_SIZE ( 4096 )
+/** @brief Maximum count of arguments of single format string stored in deferred form */
+#define LOG_FMT_MAX_ARGS ( 32 )
+
+/** @brief Class of argument consumed by conversion specification */
+typedef enum
+{
+    /** @brief No argument (`%%`) */
+    __ARG_NONE,
+    __ARG_INT,
+    __ARG_LONG,
+    __ARG_LLONG,
+    __ARG_INTMAX,
+    __ARG_SIZE,
+    __ARG_PTRDIFF,
+    __ARG_DOUBLE,
+    __ARG_LDOUBLE,
+    __ARG_PTR,
+    /** @brief Stored as `uint32_t` length followed by characters */
+    __ARG_STR,
+    /** @brief Conversion that cannot be deferred (`%n`, `%m`, `%ls`, positional...) */
+    __ARG_BAD,
+} __arg_e;
+
+/** @brief Parsed conversion specification of format string */
+typedef struct
+{
+    /** @brief Class of argument consumed by conversion */
+    __arg_e type;
+    /** @brief Whether width is given as `*` (consumes `int` argument) */
+    bool star_width;
+    /** @brief Whether precision is given as `*` (consumes `int` argument) */
+    bool star_prec;
+    /** @brief Precision given as digits, or -1 */
+    int prec;
+} __fmt_spec_t;
+
+/** @brief Format string registered in `LOG_FORMAT_BINARY` */
+typedef struct
+{
+    const char* format;
+    uint32_t id;
+    /** @brief Whether definition record was already committed to LOG file */
+    atomic_bool defined;
+    /** @brief Whether messages can be stored in deferred form - otherwise they are preformatted */
+    bool deferred;
+    /** @brief Arguments consumed by format string (`*` width / precision included) */
+    int argc;
+    __fmt_spec_t args[LOG_FMT_MAX_ARGS];
+} __fmt_info_t;
+
+/** @brief Type of record of binary LOG file */
+typedef enum
+{
+    /** @brief Definition of format string - followed by format string (no terminator) */
+    __REC_DEF = 1,
+    /** @brief Deferred message - followed by raw arguments */
+    __REC_MSG,
+    /** @brief Preformatted message - followed by text of message and newline */
+    __REC_TEXT,
+    /** @brief Definition of log category (identifier in `fmt_id`) - followed by its name */
+    __REC_CAT,
+    /** @brief Structured record - followed by its line, rendered without header */
+    __REC_RAW,
+} __rec_e;
+
+/** @brief Header of every record of binary LOG file (native byte order) */
+typedef struct
+{
+    /** @brief Length of whole record, including header */
+    uint32_t len;
+    uint16_t type;
+    uint16_t lvl;
+    uint32_t fmt_id;
+    /** @brief Log category of message */
+    uint32_t category;
+    /** @brief Timestamp in nanoseconds, of clock selected by `timestamp` of file header */
+    uint64_t ts_ns;
+} __rec_head_t;
+
+/** @brief Header of binary LOG file */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    /** @brief `log_ts_e` used to render timestamps */
+    uint32_t timestamp;
+} __file_head_t;
+
+/** @brief Per-thread state of library */
+typedef struct __thread_ctx
+{
+    /** @brief Next state in `__ctx_list` */
+    struct __thread_ctx* next;
+    /** @brief Whether owning thread has exited - state is freed once drained */
+    atomic_bool orphan;
+    /** @brief SPSC ring - filled by owning thread, drained by flusher thread */
+    struct
+    {
+        char* buf;
+        size_t mask;
+        /** @brief Total count of bytes ever pushed - modified only by owning thread */
+        _Alignas(64) atomic_size_t head;
+        /** @brief Total count of messages ever pushed - modified only by owning thread */
+        atomic_size_t pushed;
+        /** @brief Total count of bytes ever drained - modified only by flusher thread */
+        _Alignas(64) atomic_size_t tail;
+        /** @brief Total count of messages ever drained - used only by flusher thread */
+        size_t drained;
+    } ring;
+} __thread_ctx_t;
+
+/** @brief Rotated LOG file waiting for rotation thread */
+typedef struct __rotate_job
+{
+    struct __rotate_job* next;
+    /** @brief Descriptor of rotated LOG file - synced and closed by rotation thread */
+    int fd;
+    /** @brief Path of rotated LOG file */
+    char path[PATH_MAX];
+    /** @brief Path of LOG file started by rotation - it, and newer ones, are kept by retention */
+    char current[PATH_MAX];
+} __rotate_job_t;
+
+/** @brief io_uring of single thread, set up with raw system calls */
+typedef struct
+{
+    /** @brief Descriptor of ring, or -1 if io_uring is not used */
+    int fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    atomic_uint* sq_head;
+    atomic_uint* sq_tail;
+    unsigned sq_mask;
+    unsigned* sq_array;
+    atomic_uint* cq_head;
+    atomic_uint* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+    /** @brief Descriptor registered as fixed file 0, or -1 */
+    int file;
+    /** @brief Buffer registered as fixed buffer 0, or `NULL` */
+    const char* buf;
+    size_t buf_size;
+} __uring_t;
+
+/** @brief Buffered reader of `/proc` file, split into lines */
+typedef struct
+{
+    int fd;
+    size_t pos;
+    size_t len;
+    char data[LOG_DUMP_BUFFER];
+} __proc_reader_t;
+
+/** @brief Buffered writer of DUMP file */
+typedef struct
+{
+    int fd;
+    bool failed;
+    size_t len;
+    char data[LOG_DUMP_BUFFER];
+} __dump_writer_t;
+
+/** @brief Memory region parsed from `/proc/[PID]/maps` line, with its `smaps` counters */
+typedef struct
+{
+    uintmax_t start;
+    uintmax_t end;
+    char perms[5];
+    uintmax_t offset;
+    char device[16];
+    uintmax_t inode;
+    const char* mapping;
+    /** @brief Counters (in kB) in order of `__dump_smaps_t.names` */
+    uintmax_t fields[LOG_DUMP_MAX_FIELDS];
+    /** @brief Value of `VmFlags` (points into reader buffer) */
+    char vm_flags[128];
+} __dump_region_t;
+
+/** @brief Names of counters of `/proc/[PID]/smaps`, learned from first region */
+typedef struct
+{
+    size_t count;
+    char names[LOG_DUMP_MAX_FIELDS][32];
+    bool complete;
+} __dump_smaps_t;
+
+/** @brief In-memory section of DUMP file, written by single provider */
+struct log_dump_writer
+{
+    char* data;
+    size_t len;
+    size_t cap;
+    bool truncated;
+};
+
+/** @brief Registered DUMP provider */
+typedef struct
+{
+    char name[LOG_DUMP_NAME_SIZE];
+    log_dump_provider_f provider;
+    void* ctx;
+    int priority;
+    unsigned timeout_ms;
+    /** @brief Count of runs not finished yet - slot is never freed, so counter outlives provider */
+    atomic_uint running;
+} __dump_provider_t;
+
+/** @brief Single run of DUMP provider - shared by DUMP thread and worker running provider */
+typedef struct
+{
+    __dump_provider_t provider;
+    atomic_uint* running;
+    log_dump_lvl_e lvl;
+    log_dump_writer_t writer;
+    struct timespec deadline;
+    /** @brief Whether provider returned - protected by `mux` */
+    bool done;
+    /** @brief Count of owners (DUMP thread and worker) - protected by `mux` */
+    int refs;
+    pthread_mutex_t mux;
+    pthread_cond_t cond;
+} __dump_job_t;
+
+/** @brief DUMP order, queued by signal action */
+typedef struct
+{
+    log_dump_lvl_e lvl;
+    log_dump_section_e sections;
+    /** @brief Process that sent SIGDUMP */
+    pid_t pid;
+    /** @brief Real user of process that sent SIGDUMP */
+    uid_t uid;
+    /** @brief Number of order, counted since initialization */
+    unsigned seq;
+    /** @brief Kind of order - DUMP level * 8 + sections, `LOG_STATS_KIND` or `LOG_CONTROL_KIND` */
+    unsigned kind;
+} __dump_cmd_t;
+
+/** @brief Slot of DUMP order queue - `seq` tells whether it is free or filled for given position */
+typedef struct
+{
+    atomic_size_t seq;
+    __dump_cmd_t cmd;
+} __dump_cell_t;
+
+/** @brief Control block of process, in POSIX shared memory `LOG_CONTROL_NAME` - written by
+ *         `log_control_*` functions of other process, read by logger without syscalls */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    /** @brief Count of changes made through `log_control_*` functions */
+    atomic_uint generation;
+    /** @brief Count of levels enabled for every category - `__log_enabled` points here */
+    volatile sig_atomic_t enabled[LOG_MAX_CATEGORIES];
+    /** @brief Durability policy - `log_sync_e` in low `LOG_SYNC_POLICY_BITS`,
+     *         policy parameter in remaining bits */
+    volatile sig_atomic_t sync;
+    /** @brief Size after which LOG file is rotated (0 - never) */
+    atomic_ullong rotate_bytes;
+    /** @brief Time in seconds after which LOG file is rotated (0 - never) */
+    atomic_uint rotate_interval_s;
+} __control_t;
+
+/** @brief Control block of other process, mapped by `log_control_open` */
+struct log_control
+{
+    pid_t pid;
+    __control_t* block;
+    /** @brief Whether anything was changed through handle */
+    bool changed;
+};
+
+/** @brief Logger instance opened by `log_open` - default instance only marks
+ *         LOG file of `log_init`, which is kept in globals */
+struct log
+{
+    char name[LOG_INSTANCE_NAME_SIZE];
+    int fd;
+    /** @brief Mutex protecting writes to `fd` and sync state */
+    pthread_mutex_t mux;
+    /** @brief Durability policy packed by `__sync_pack` */
+    int sync;
+    size_t sync_pending;
+    struct timespec sync_last;
+    /** @brief Count of threads printing notices of library to instance (see `__log_pin`) -
+     *         `log_close` waits for them */
+    atomic_uint pins;
+    /** @brief Next open instance */
+    struct log* next;
+};
+
+/** @brief Header of tail ring, in POSIX shared memory `LOG_TAIL_NAME` - followed by slots */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size;
+    /** @brief Count of slots (power of 2) */
+    uint64_t slots;
+    /** @brief Count of records dropped, since their slot was still written by lapped writer */
+    atomic_ullong dropped;
+    /** @brief Position of next record - claimed by writers with `fetch_add` */
+    _Alignas(64) atomic_ullong head;
+} __tail_head_t;
+
+/** @brief Slot of tail ring - `seq` is seqlock of record at position `pos`:
+ *         2 * `pos` + 1 while it is written, 2 * `pos` + 2 once it is complete */
+typedef struct
+{
+    atomic_ullong seq;
+    uint32_t len;
+    char data[LOG_TAIL_SLOT_SIZE - sizeof(atomic_ullong) - sizeof(uint32_t)];
+} __tail_slot_t;
+
+/** @brief Tail ring of other process, attached by `log_tail_open` */
+struct log_tail
+{
+    const __tail_head_t* head;
+    size_t size;
+    /** @brief Position of next record to read */
+    uint64_t pos;
+    /** @brief Position that reader waits on since `stall_since` */
+    uint64_t stall_pos;
+    struct timespec stall_since;
+};
+
+/** @brief Latency histogram - see `log_stats_hist_t` */
+typedef struct
+{
+    atomic_ullong count[LOG_STATS_BUCKETS];
+    atomic_ullong total_ns;
+} __stats_hist_t;
+
+/** @brief Self-instrumentation counters of single thread - modified only by owning thread,
+ *         read by `log_stats` */
+typedef struct __stats
+{
+    /** @brief Next block in `__stats_list` */
+    struct __stats* next;
+    /** @brief Whether block belongs to running thread - blocks of exited threads are reused */
+    atomic_bool used;
+    atomic_ullong accepted;
+    atomic_ullong ignored;
+    atomic_ullong dropped;
+    atomic_ullong suppressed;
+    atomic_ullong failed;
+    atomic_ullong bytes;
+    __stats_hist_t write;
+    __stats_hist_t sync;
+    __stats_hist_t lock_wait;
+    __stats_hist_t dump;
+} __stats_t;
+
+/** @brief Flight recorder ring of single thread - written only by owning thread,
+ *         read by DUMP thread and crash handler */
+typedef struct __flight
+{
+    /** @brief Next ring in `__flight_list` */
+    struct __flight* next;
+    /** @brief Whether ring belongs to running thread - rings of exited threads are kept
+     *         until reused */
+    atomic_bool used;
+    /** @brief Thread (last) owning ring */
+    atomic_int tid;
+    /** @brief Count of bytes ever captured - position of next one is `head` & (`size` - 1) */
+    atomic_ullong head;
+    /** @brief Size of `data`, power of 2 */
+    size_t size;
+    char data[];
+} __flight_t;
+
+/** @brief Rate limit state of single call site in calling thread - written only by it,
+ *         other threads read it and claim `suppressed` */
+typedef struct
+{
+    /** @brief Format string identifying call site, or `NULL` if slot is free */
+    _Atomic(const char*) format;
+    /** @brief Theoretical arrival time [ns] of next message - message passes if it is at most
+     *        `__rate_burst_ns` ahead (token bucket in form of generic cell rate algorithm) */
+    atomic_ullong tat;
+    /** @brief Messages suppressed since count was last claimed */
+    atomic_uint suppressed;
+    /** @brief Target of last suppressed message, that its count is reported to */
+    _Atomic(log_t*) log;
+    _Atomic(log_category_t) cat;
+    _Atomic(log_lvl_e) lvl;
+} __rate_slot_t;
+
+/** @brief Last message of calling thread, that following identical ones are collapsed into -
+ *         written only by it, other threads read it and claim `repeated` */
+typedef struct
+{
+    _Atomic(const char*) format;
+    _Atomic(log_t*) log;
+    _Atomic(log_category_t) cat;
+    _Atomic(log_lvl_e) lvl;
+    /** @brief Hash and length of body of record (without header) - read only by owning thread */
+    uint64_t hash;
+    size_t len;
+    /** @brief Messages collapsed since count was last claimed, in run started at `since` [ns] */
+    atomic_uint repeated;
+    atomic_ullong since;
+} __repeat_t;
+
+/** @brief Rate limit and collapsing state of single thread - counts of windows that closed
+ *         are claimed by whichever thread reports them first, without locks */
+typedef struct __rate_state
+{
+    /** @brief Next block in `__rate_list` */
+    struct __rate_state* next;
+    /** @brief Whether block belongs to running thread - blocks of exited threads are reused */
+    atomic_bool used;
+    /** @brief Run of repeated messages */
+    __repeat_t repeat;
+    /** @brief Rate limit slots, indexed by hash of format string */
+    __rate_slot_t slots[1 << LOG_RATE_SLOTS_BITS];
+} __rate_state_t;
+
+/** @brief Structured record being serialized - starts in `__tls_record`, moves to heap if needed */
+typedef struct
+{
+    char* data;
+    size_t len;
+    size_t cap;
+    /** @brief Whether last put did not fit in maximum record size */
+    bool overflow;
+} __kv_buf_t;
 
 /** @brief Temporary placeholder for `errno` in throwing blocks */
 int __errno;
@@ -31,39 +602,435 @@ int __errno;
 const char* __path;
 /** @brief Length of `__path` (used to ignore trailing characters) */
 size_t __path_len;
-/** @brief `File descriptor` for current LOG file */
+/** @brief `File descriptor` for current LOG file - swapped only by writer on rotation */
 int __log_fd;
-/** @brief Current log level - should only allow values of `log_lvl_e` */
-volatile sig_atomic_t __current_log_lvl = LOG_LVL_OFF;
-/** @brief `File descriptor`s for pipe queue used by DUMP */
-struct
-{
-    int read;
-    int write;
-} __dump_pipe;
+/** @brief Path of current LOG file */
+char __log_name[PATH_MAX];
+/** @brief Count of bytes written to current LOG file - used only by writer */
+size_t __log_bytes;
+/** @brief Count of bytes written to current LOG file when it was created (header) */
+size_t __log_base;
+/** @brief Second (realtime) in which last LOG file was created */
+time_t __log_name_sec = 0;
+/** @brief Sequence number of last LOG file created within `__log_name_sec` */
+unsigned __log_name_seq = 0;
+/** @brief Control block used before it is shared, and if shared memory is unavailable -
+ *         zero-initialized, so that every category logs nothing */
+__control_t __control_local;
+/** @brief Current control block - shared one, while library is initialized */
+__control_t* __control = &__control_local;
+/** @brief Shared control block - stays mapped after `deinit`, since `log_printf` callers
+ *         may still hold pointer to it, and is replaced in place by next `init` */
+__control_t* __control_shared = NULL;
+/** @brief Name of shared control block */
+char __control_name[64];
+/** @brief Whether LOG file is shared with forked children */
+bool __shared;
+/** @brief Guard of registering fork handlers - they stay registered after `deinit` */
+pthread_once_t __fork_once = PTHREAD_ONCE_INIT;
+/** @brief Way control signals are serviced */
+log_signals_e __signals;
+/** @brief `signalfd` of control signals - used only in `LOG_SIGNALS_THREAD` */
+int __signal_fd;
+/** @brief `epoll` instance of control thread, watching `__signal_fd` and `__signal_event` */
+int __signal_epoll;
+/** @brief `eventfd` stopping control thread */
+int __signal_event;
+/** @brief Control thread identifier */
+pthread_t __signal_tid;
+/** @brief Tail ring that records are published to - `NULL` if it is disabled */
+__tail_head_t* __tail = NULL;
+/** @brief Tail ring of previous initialization - stays mapped until next `init`,
+ *         since `log_printf` callers may still be publishing to it */
+__tail_head_t* __tail_mapped = NULL;
+/** @brief Size of `__tail_mapped` */
+size_t __tail_mapped_size;
+/** @brief Name of tail ring */
+char __tail_name[64];
+/** @brief Process that created tail ring - forked children publish to it too,
+ *         but only creator removes its name */
+pid_t __tail_owner;
+/** @brief Count of levels enabled for every log category (current logging level + 1) -
+ *         so that `LOG_LVL_OFF` category logs nothing */
+volatile sig_atomic_t* __log_enabled = __control_local.enabled;
+/** @brief Names of log categories - default category has empty name */
+char __category_names[LOG_MAX_CATEGORIES][LOG_CATEGORY_NAME_SIZE];
+/** @brief Count of registered log categories, including default one */
+atomic_uint __category_count = 1;
+/** @brief Mutex protecting registration of log categories */
+pthread_mutex_t __category_mux = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Format of structured records */
+log_kv_format_e __kv_format;
+/** @brief Count of structured records written since initialization */
+atomic_ullong __kv_seq;
+/** @brief Kernel ID of calling thread, or 0 if not read yet */
+_Thread_local pid_t __tls_tid = 0;
+/** @brief Format of timestamp in message header */
+log_ts_e __ts_mode;
+/** @brief Maximum size of single record */
+size_t __max_record;
+/** @brief Format of LOG file */
+log_format_e __format;
+/** @brief Registry of format strings - open addressing by address of format string */
+_Atomic(__fmt_info_t*) __fmt_table[LOG_FMT_TABLE_SIZE];
+/** @brief Last assigned format string ID */
+atomic_uint __fmt_last_id = 0;
+/** @brief Level tags opening header of message */
+const char __lvl_tags[][8] = { "[MIN @ ", "[STD @ ", "[MAX @ " };
+/** @brief Count of messages written since last sync - used only by writer */
+size_t __sync_pending;
+/** @brief Time of last sync - used only by writer */
+struct timespec __sync_last;
+/** @brief `eventfd` waking DUMP thread when order is queued */
+int __dump_event;
+/** @brief Bounded queue of DUMP orders - pushed by signal actions, popped by DUMP thread */
+__dump_cell_t __dump_queue[LOG_DUMP_QUEUE_SIZE];
+/** @brief Next position of `__dump_queue` to push */
+atomic_size_t __dump_queue_head;
+/** @brief Next position of `__dump_queue` to pop - used only by DUMP thread */
+size_t __dump_queue_tail;
+/** @brief Bit for every kind (level and sections) of DUMP order queued, but not picked up yet */
+atomic_ullong __dump_pending;
+/** @brief Count of orders merged into pending one, for every kind of DUMP order */
+atomic_uint __dump_coalesced[LOG_DUMP_KINDS];
+/** @brief Count of DUMP and STATS orders received */
+atomic_uint __dump_seq;
+/** @brief Whether DUMP thread should wait for more orders */
+atomic_bool __dump_run;
 /** @brief DUMP thread identifier */
 pthread_t __dump_tid;
 
+/** @brief Whether flusher and DUMP threads write through io_uring */
+bool __io_uring;
+/** @brief io_uring of flusher thread - LOG file is registered in it */
+__uring_t __flush_uring = { .fd = -1, .file = -1 };
+/** @brief io_uring of DUMP thread - its writer buffer is registered in it */
+__uring_t __dump_uring = { .fd = -1, .file = -1 };
+/** @brief io_uring of calling thread, or `NULL` */
+_Thread_local __uring_t* __tls_uring = NULL;
+/** @brief Writer of DUMP files, owned by DUMP thread */
+__dump_writer_t* __dump_writer = NULL;
+/** @brief Fatal signals caught when crash handler is enabled */
+const int __crash_signals[LOG_CRASH_SIGNALS] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+/** @brief Names of `__crash_signals` - `strsignal` is not async-signal-safe */
+const char* const __crash_names[LOG_CRASH_SIGNALS] = { "SIGSEGV", "SIGBUS", "SIGFPE", "SIGILL", "SIGABRT" };
+/** @brief Whether fatal signals are caught */
+bool __crash_enabled = false;
+/** @brief Actions of fatal signals replaced by crash handler */
+struct sigaction __crash_old[LOG_CRASH_SIGNALS];
+/** @brief Offset of local time from UTC in seconds, read by `log_init` - `localtime_r`
+ *         is not async-signal-safe */
+long __crash_gmtoff;
+/** @brief Whether some thread is handling fatal signal already */
+atomic_bool __crash_active;
+/** @brief Thread freeing state of exited thread in `__flush_rings`, or 0 - crash handler walks
+ *         states only once it is done, and no state is freed after that */
+atomic_int __crash_reclaimer;
+/** @brief Alternate signal stack of calling thread, or `NULL` */
+_Thread_local void* __tls_altstack = NULL;
+/** @brief Mode of writing messages to LOG file */
+log_mode_e __mode;
+/** @brief Capacity of per-thread rings (power of 2) */
+size_t __ring_size;
+/** @brief Maximum time between flusher thread passes */
+unsigned __flush_interval_ms;
+/** @brief Size of LOG file chunk mapped at once in `LOG_MODE_MMAP` (multiple of page size) */
+size_t __mmap_chunk;
+/** @brief Offset of first unreserved byte of LOG file in `LOG_MODE_MMAP` */
+atomic_size_t __mmap_offset;
+/** @brief Offset up to which LOG file was synced in `LOG_MODE_MMAP` */
+atomic_size_t __mmap_synced;
+/** @brief Count of messages written in `LOG_MODE_MMAP` - used by `LOG_SYNC_COUNT` */
+atomic_size_t __mmap_messages;
+/** @brief Time (monotonic nanoseconds) of last sync in `LOG_MODE_MMAP` */
+atomic_llong __mmap_last_sync;
+/** @brief Mappings of LOG file chunks in `LOG_MODE_MMAP` - index is offset / chunk size */
+struct
+{
+    /** @brief Address of mapping - `NULL` if not mapped yet, or already retired */
+    _Atomic(char*) addr;
+    /** @brief Count of bytes copied into chunk - chunk is retired once it is full */
+    atomic_size_t committed;
+} __mmap_chunks[LOG_MMAP_MAX_CHUNKS];
+/** @brief Mutex protecting mapping of new chunks (taken once per chunk) */
+pthread_mutex_t __mmap_mux = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Time (monotonic seconds) at which current LOG file was started - used only by writer */
+time_t __rotate_since;
+/** @brief Whether rotated LOG files are compressed */
+bool __rotate_compress;
+/** @brief Maximum count of rotated LOG files kept (0 - unlimited) */
+unsigned __retain_segments;
+/** @brief Maximum total size of rotated LOG files kept (0 - unlimited) */
+size_t __retain_bytes;
+/** @brief Rotation thread identifier */
+pthread_t __rotate_tid;
+/** @brief Whether rotation thread was launched */
+bool __rotate_running = false;
+/** @brief Whether rotation thread should wait for more jobs */
+bool __rotate_run;
+/** @brief Queue of rotated LOG files - protected by `__rotate_mux` */
+__rotate_job_t* __rotate_jobs = NULL;
+/** @brief Last `next` link of `__rotate_jobs` */
+__rotate_job_t** __rotate_jobs_tail = &__rotate_jobs;
+/** @brief Mutex protecting `__rotate_jobs` */
+pthread_mutex_t __rotate_mux = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Condition signalled when job is added to `__rotate_jobs` */
+pthread_cond_t __rotate_cond = PTHREAD_COND_INITIALIZER;
+/** @brief Flusher thread identifier */
+pthread_t __flush_tid;
+/** @brief Whether flusher thread should keep running */
+atomic_bool __flush_run;
+/** @brief Semaphore used to wake flusher thread before interval passes */
+sem_t __flush_sem;
+/** @brief Key used to detect exit of thread owning per-thread state */
+pthread_key_t __ctx_key;
+/** @brief Registry of per-thread states - pushed lock-free, removed only by flusher thread */
+_Atomic(__thread_ctx_t*) __ctx_list = NULL;
+/** @brief Generation of initialization - invalidates per-thread states of previous ones */
+atomic_uint __init_gen = 0;
+/** @brief Per-thread state of calling thread */
+_Thread_local __thread_ctx_t* __tls_ctx = NULL;
+/** @brief Generation of initialization that `__tls_ctx` belongs to */
+_Thread_local unsigned __tls_gen = 0;
+/** @brief Per-thread buffer that records are assembled in */
+_Thread_local char __tls_record[LOG_TLS_RECORD_SIZE];
+/** @brief Per-thread cache of broken-down wall-clock time, re-rendered once per second */
+_Thread_local struct
+{
+    time_t sec;
+    struct tm tm;
+    /** @brief `YYYY-MM-DD|HH:MM:SS` */
+    char text[20];
+} __tls_ts = { .sec = -1 };
+
+
+/** @brief Counters shared by threads that cannot allocate their own block -
+ *         always in use, and last in `__stats_list` */
+__stats_t __stats_shared = { .next = NULL, .used = true };
+/** @brief Self-instrumentation counters of all threads that ever logged - blocks are never freed,
+ *         only the head is ever modified concurrently */
+_Atomic(__stats_t*) __stats_list = &__stats_shared;
+/** @brief Count of threads that ever acquired block of `__stats_list` */
+atomic_uint __stats_threads;
+/** @brief Key of thread-specific data releasing block of `__stats_list` when thread exits */
+pthread_key_t __stats_key;
+/** @brief Guard of `__stats_key` creation - counters outlive initialization of library */
+pthread_once_t __stats_once = PTHREAD_ONCE_INIT;
+/** @brief Counters of calling thread */
+_Thread_local __stats_t* __tls_stats = NULL;
+/** @brief Interval [ns] between messages of call site allowed by rate limit - 0 means no limit */
+uint64_t __rate_interval_ns = 0;
+/** @brief How far [ns] ahead of current time rate limit may be spent (burst) */
+uint64_t __rate_burst_ns = 0;
+/** @brief Whether repeated messages are collapsed */
+bool __collapse = false;
+/** @brief Size of flight recorder rings - 0 means no recorder */
+size_t __flight_size = 0;
+volatile sig_atomic_t __log_capture = 0;
+/** @brief Flight recorder rings of all threads that ever logged - never freed,
+ *         only the head is ever modified concurrently */
+_Atomic(__flight_t*) __flight_list = NULL;
+/** @brief Monotonic time [ns] of last flight DUMP ordered by `LOG_LVL_MIN` message */
+atomic_ullong __flight_ordered = 0;
+/** @brief Flight recorder ring of calling thread */
+_Thread_local __flight_t* __tls_flight = NULL;
+/** @brief Whether calling thread is DUMP or signal thread of library - its messages
+ *         do not order flight DUMP */
+_Thread_local bool __tls_library = false;
+/** @brief Rate limit and collapsing state of all threads that ever logged - never freed,
+ *         only the head is ever modified concurrently */
+_Atomic(__rate_state_t*) __rate_list = NULL;
+/** @brief Rate limit and collapsing state of calling thread */
+_Thread_local __rate_state_t* __tls_rate = NULL;
 
-/** @brief Whether `pmap` command is present in system */
-bool __pmap_present;
+/** @brief Registered DUMP providers - slots with `provider` == `NULL` are free */
+__dump_provider_t __dump_providers[LOG_DUMP_MAX_PROVIDERS];
+/** @brief Mutex protecting `__dump_providers` */
+pthread_mutex_t __dump_providers_mux = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Default logger instance, returned by `log_default` */
+log_t __log_default = { .fd = -1 };
+/** @brief Logger instances opened by `log_open` */
+log_t* __instances = NULL;
+/** @brief Mutex protecting `__instances` */
+pthread_mutex_t __instances_mux = PTHREAD_MUTEX_INITIALIZER;
 /** @brief Whether library is already initialized */
 bool __init_ready = false;
 /** @brief Mutex protecting from duplicate `init` / `deinit` calls */
 pthread_mutex_t __init_mux = PTHREAD_MUTEX_INITIALIZER;
 /** @brief Mutex protecting from synchronous writes to LOG file */
 pthread_mutex_t __write_mux = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Whether writer sections may be entered - cleared by `log_deinit` before it tears
+ *         down rings, mapping and format registry */
+atomic_bool __writers_open = false;
+/** @brief Count of threads inside writer sections (see `__writer_enter`) */
+atomic_uint __writers_inflight = 0;
 
 /**
  * @brief Create a file name of template:
- *        pid${PID}_${YYYY-MM-DD-HH.mm.ss}.${_extension}
+ *        pid${PID}_${YYYY-MM-DD-HH.mm.ss}.${_extension}, or if `_seq` is not 0
+ *        pid${PID}_${YYYY-MM-DD-HH.mm.ss}_${_seq:03}.${_extension} - if `_name` is not `NULL`,
+ *        then it follows PID: pid${PID}_${_name}_${YYYY-MM-DD-HH.mm.ss}...
  * @return Dynamically-allocated path
  */
-char* __create_file_name(const char* _extension);
+char* __create_file_name(const char* _name, const char* _extension, unsigned _seq);
+/**
+ * @brief Writes path of file named like by `__create_file_name`, with time `_tm`, to `_out` -
+ *        async-signal-safe
+ * @return Length of path (null-string-terminator is written)
+ */
+size_t __render_file_name(char* _out, const char* _name, const char* _extension, unsigned _seq,
+    const struct tm* _tm);
+/**
+ * @brief Creates new LOG file (never reusing existing one), storing its path in `__log_name`,
+ *        and writes header and format string definitions to it in `LOG_FORMAT_BINARY`
+ * @return `File descriptor` of created file, or -1 on error
+ */
+int __open_log_file(size_t* _written);
+/**
+ * @brief Returns broken-down local time of `_sec`, from per-thread cache
+ *        (`localtime_r` is called only when second changes)
+ */
+const struct tm* __cached_tm(time_t _sec);
+/**
+ * @brief Reads clock selected by `__ts_mode` into `_now`
+ */
+void __read_clock(struct timespec* _now);
+/**
+ * @brief Writes current timestamp to `_out` (at least 28 bytes), formatted by `__ts_mode`
+ * @return Length of timestamp (no null-string-terminator is written)
+ */
+size_t __format_timestamp(char* _out);
+/**
+ * @brief Writes timestamp `_ts` to `_out` (at least 28 bytes), formatted by `_mode`
+ * @return Length of timestamp (no null-string-terminator is written)
+ */
+size_t __render_timestamp(char* _out, const struct timespec* _ts, log_ts_e _mode);
+/**
+ * @brief Writes `_value` as exactly `_width` decimal digits (zero-padded) to `_out`
+ */
+void __put_digits(char* _out, unsigned long _value, int _width);
+/**
+ * @brief Writes `_value` in decimal, without padding, to `_out` (at least 20 bytes)
+ * @return Count of digits written
+ */
+size_t __put_uint(char* _out, unsigned long long _value);
+/**
+ * @brief Copies `_str` without null-string-terminator to `_out`
+ * @return Length of `_str`
+ */
+size_t __put_str(char* _out, const char* _str);
+/**
+ * @brief Writes `_tm` as `YYYY-MM-DD${_sep}HH${_time_sep}MM${_time_sep}SS` (19 bytes) to `_out`
+ */
+void __put_tm(char* _out, const struct tm* _tm, char _sep, char _time_sep);
 /**
  * @brief If `_lock == true`, then lock file `_fd`, else unlock it
  */
 log_res_e __change_file_lock(int _fd, bool _lock);
+/**
+ * @brief Packs durability policy `_sync` and its parameter into value of `__control_t.sync`
+ * @return -1 if `_sync` or `_param` is invalid
+ */
+int __sync_pack(log_sync_e _sync, unsigned _param);
+/**
+ * @brief Applies durability policy after `_messages` were written to LOG file -
+ *        must be called only by writer (under `__write_mux`, or by flusher thread)
+ */
+void __sync_after(size_t _messages);
+/**
+ * @brief Syncs `_fd` if durability policy `_cfg` (packed by `__sync_pack`) requires it,
+ *        counting `_messages` into `_pending` - state of policy is kept by caller
+ */
+void __sync_file(int _fd, int _cfg, size_t* _pending, struct timespec* _last, size_t _messages);
+/**
+ * @brief Counts `_messages` into `_pending`, and decides whether durability policy `_cfg`
+ *        requires sync now (`_data_only` - whether `fdatasync` is enough) - if it was
+ *        decided either way, then state of policy is reset
+ */
+bool __sync_due(int _cfg, size_t* _pending, struct timespec* _last, size_t _messages,
+    bool* _data_only);
+/**
+ * @brief Reads next line of `/proc` file, without newline
+ * @return Line valid until next call, or `NULL` at end of file
+ */
+char* __proc_getline(__proc_reader_t* _reader);
+/**
+ * @brief Appends `_len` bytes of `_data` to DUMP file, writing buffer out when it is full
+ */
+void __dump_put(__dump_writer_t* _writer, const char* _data, size_t _len);
+/**
+ * @brief Appends formatted text to DUMP file - see `__dump_put`
+ */
+void __dump_printf(__dump_writer_t* _writer, const char* _format, ...)
+    __attribute__((format(printf, 2, 3)));
+/**
+ * @brief Writes out buffered part of DUMP file
+ */
+void __dump_flush(__dump_writer_t* _writer);
+/**
+ * @brief Parses `/proc/[PID]/maps` (or `smaps` region header) line into `_region`
+ * @return Whether `_line` is region header
+ */
+bool __dump_parse_region(char* _line, __dump_region_t* _region);
+/**
+ * @brief Writes row of `_region` (or column headers if `_region` is `NULL`) in format of `_lvl`
+ */
+void __dump_region(__dump_writer_t* _writer, log_dump_lvl_e _lvl,
+    const __dump_smaps_t* _smaps, const __dump_region_t* _region);
+/**
+ * @brief Renders memory map of process in format of `_lvl` to `_writer`,
+ *        reading `/proc/self/maps`, `smaps` and `smaps_rollup` directly
+ */
+log_res_e __dump_render(__dump_writer_t* _writer, log_dump_lvl_e _lvl);
+/**
+ * @brief Writes header of DUMP file - process, its command line and origin of `_cmd`
+ */
+void __dump_header(__dump_writer_t* _writer, const __dump_cmd_t* _cmd, unsigned _coalesced);
+/**
+ * @brief Creates DUMP file ordered by `_cmd`
+ */
+void __dump_create(const __dump_cmd_t* _cmd, unsigned _coalesced);
+/**
+ * @brief Creates STATS file ordered by `_cmd` - snapshot of self-instrumentation counters
+ */
+void __stats_create(const __dump_cmd_t* _cmd, unsigned _coalesced);
+/**
+ * @brief Creates new DUMP or STATS file (never reusing existing one)
+ * @return `File descriptor` of created file and its path in `_path`, or -1 on error
+ */
+int __dump_open(const char* _extension, char** _path);
+/**
+ * @brief Queues order of `_kind`, or merges it with pending one of same kind, and wakes
+ *        DUMP thread - async-signal-safe
+ */
+void __dump_order(unsigned _kind, __dump_cmd_t _cmd);
+/**
+ * @brief Queues DUMP order - async-signal-safe, lock-free
+ * @return Whether order was queued (false if queue is full)
+ */
+bool __dump_queue_push(const __dump_cmd_t* _cmd);
+/**
+ * @brief Takes oldest DUMP order from queue - must be called only by DUMP thread
+ * @return Whether order was taken
+ */
+bool __dump_queue_pop(__dump_cmd_t* _cmd);
+/**
+ * @brief Stops DUMP thread - orders not picked up yet are discarded
+ */
+void __dump_stop(void);
+/**
+ * @brief Runs registered DUMP providers concurrently, and appends their sections
+ *        to `_writer` in priority order, skipping those not finished within their timeout
+ */
+void __dump_providers_run(__dump_writer_t* _writer, log_dump_lvl_e _lvl);
+/**
+ * @brief Drops single reference to `_job`, freeing it after last one
+ */
+void __dump_job_release(__dump_job_t* _job);
+/**
+ * @brief `Runnable` running single DUMP provider
+ */
+void* __dump_job_thread(void* _job);
 /**
  * @brief Send rt signal `_signal` with `_value` to process `_pid`
  */
@@ -74,29 +1041,626 @@ log_res_e __dispatch_signal(pid_t _pid, int _signal, int _value);
 log_res_e __register_signal(int _signal, void (*_action) (int, siginfo_t*, void*));
 
 /**
- * @brief `Runnable` for creating DUMP files
+ * @brief Enters writer section - code that touches LOG file, per-thread rings, mapping
+ *        or format registry. Refused once `log_deinit` started
+ * @return Whether section was entered (then `__writer_leave` must follow)
  */
-void* __dump_thread(void* _);
+bool __writer_enter(void);
 /**
- * @brief Signal action for changing LOG level
+ * @brief Leaves writer section entered by `__writer_enter`
  */
-void __log_action(int _signal, siginfo_t* _info, void* _);
+void __writer_leave(void);
 /**
- * @brief Signal action for ordering DUMP files
+ * @brief Refuses new writer sections, and waits until threads leave entered ones
  */
-void __dump_action(int _signal, siginfo_t* _info, void* _);
-
-
-//============================================================================//
-
+void __writer_quiesce(void);
+/**
+ * @brief Prints formatted message of category `_cat` to LOG file - see `log_printf`
+ */
+log_res_e __log_vprintf(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args);
+/**
+ * @brief Captures, checks and prints message of `__log_vprintf`, inside writer section
+ */
+log_res_e __log_vsubmit(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args);
+/**
+ * @brief Formats message and commits it to LOG file of `_log`, after all checks passed
+ */
+log_res_e __log_emit(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args);
+/**
+ * @brief Commits record `_record` (`__tls_record`, or heap one that is freed) to LOG file of `_log`
+ */
+log_res_e __log_commit(log_t* _log, char* _record, size_t _len);
+/**
+ * @brief Prints message of library on behalf of call site, bypassing rate limit and collapsing -
+ *        dropped if level of `_cat` is now lower. Caller is inside writer section (or is
+ *        `log_deinit` after writers were quiesced), and pinned instance `_log`
+ */
+void __log_notice(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format, ...);
+/**
+ * @brief Keeps instance `_log` from being freed by `log_close`, until `__log_unpin`
+ * @return Whether `_log` is still open (default instance always is)
+ */
+bool __log_pin(log_t* _log);
+/**
+ * @brief Releases instance `_log` pinned by `__log_pin`
+ */
+void __log_unpin(log_t* _log);
+/**
+ * @brief Gives calling thread block of `__rate_list`, reusing block of exited thread
+ * @return Block, or `NULL` if it cannot be allocated
+ */
+__rate_state_t* __rate_local(void);
+/**
+ * @brief Checks rate limit of call site `_format` in calling thread, reporting messages
+ *        it suppressed before, once it passes again
+ * @return Whether message passes - also if state of calling thread cannot be allocated
+ */
+bool __rate_take(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format);
+/**
+ * @brief Claims count of messages suppressed in `_slot`, and prints it
+ */
+void __rate_report(__rate_slot_t* _slot);
+/**
+ * @brief Hashes body of text record `_record` of category `_cat` (without header, which differs
+ *        in timestamp), storing its length in `_body_len`
+ */
+uint64_t __record_hash(log_category_t _cat, const char* _record, size_t _len, size_t* _body_len);
+/**
+ * @brief Checks whether record with body of `_hash` and `_len` repeats `_run` (counting it then) -
+ *        run that lasts longer than `LOG_REPEAT_WINDOW_NS` is not continued
+ * @return Whether record is collapsed
+ */
+bool __repeat_match(__repeat_t* _run, log_t* _log, log_category_t _cat, log_lvl_e _lvl,
+    const char* _format, uint64_t _hash, size_t _len);
+/**
+ * @brief Claims count of messages collapsed in `_run`, and prints it
+ */
+void __repeat_report(__repeat_t* _run);
+/**
+ * @brief Prints counts of messages suppressed and collapsed in `_rate` for `_log`, or for all
+ *        targets if `_log` is `NULL` - only of windows that closed, if `_expired`
+ */
+void __rate_state_flush(__rate_state_t* _rate, log_t* _log, bool _expired);
+/**
+ * @brief Prints counts of messages suppressed and collapsed by all threads for `_log`,
+ *        or for all targets if `_log` is `NULL` - only of windows that closed, if `_expired`.
+ *        Caller is inside writer section, or is `log_deinit` after writers were quiesced
+ */
+void __rate_flush(log_t* _log, bool _expired);
+/**
+ * @brief Gives calling thread flight recorder ring of current size, reusing ring of exited thread
+ * @return Ring, or `NULL` if it cannot be allocated
+ */
+__flight_t* __flight_local(void);
+/**
+ * @brief Copies text record `_record` into flight recorder ring of calling thread
+ */
+void __flight_put(const char* _record, size_t _len);
+/**
+ * @brief Finds first whole record of `_flight` at or after position `_from` - unless it is 0,
+ *        record it falls into may be partly overwritten, so it is skipped
+ * @return Position of record, or `_head` if there is none
+ */
+unsigned long long __flight_start(const __flight_t* _flight, unsigned long long _from,
+    unsigned long long _head);
+/**
+ * @brief Writes section of flight recorder rings of all threads to DUMP file
+ */
+void __flight_render(__dump_writer_t* _writer);
+/**
+ * @brief Writes flight recorder rings of all threads to `_fd`, without copying - async-signal-safe
+ */
+void __flight_crash(int _fd);
+/**
+ * @brief Reads coarse monotonic clock, used by rate limit and collapsing
+ * @return Time in nanoseconds
+ */
+uint64_t __rate_now(void);
+/**
+ * @brief Sets logging level of category `_cat`, or of every category if `_cat`
+ *        is `LOG_MAX_CATEGORIES` - async-signal-safe
+ */
+void __log_set_level(log_category_t _cat, log_lvl_e _lvl);
+/**
+ * @brief Commits definition record of category `_cat` to LOG file (`LOG_FORMAT_BINARY`)
+ */
+void __category_define(log_category_t _cat);
+/**
+ * @brief Writes definition records of all registered categories to `_fd`
+ * @return Count of bytes written
+ */
+size_t __category_write_all(int _fd);
+/**
+ * @brief Makes room for `_len` more bytes in `_buf`, moving it to heap when it outgrows
+ *        `__tls_record` - sets `overflow` if record would exceed maximum record size
+ */
+bool __kv_reserve(__kv_buf_t* _buf, size_t _len);
+/**
+ * @brief Appends `_len` bytes of `_data` to `_buf`
+ */
+void __kv_put(__kv_buf_t* _buf, const char* _data, size_t _len);
+/**
+ * @brief Appends decimal representation of `_value` (negated if `_negative`) to `_buf`
+ */
+void __kv_put_uint(__kv_buf_t* _buf, unsigned long long _value, bool _negative);
+/**
+ * @brief Appends string `_value` to `_buf` - quoted and escaped for JSON, or for logfmt
+ *        (quoted only if needed)
+ */
+void __kv_put_str(__kv_buf_t* _buf, const char* _value);
+/**
+ * @brief Appends `_key` and `_value` of single field to `_buf`
+ */
+void __kv_put_key(__kv_buf_t* _buf, const char* _key);
+/**
+ * @brief Appends value of `_field` to `_buf`
+ */
+void __kv_put_value(__kv_buf_t* _buf, const log_field_t* _field);
+/**
+ * @brief Assembles whole record (header, formatted message, newline) in `__tls_record`,
+ *        or in heap if it does not fit, truncating it to `__max_record`
+ * @return Record (must be freed if it is not `__tls_record`), or `NULL` on error
+ */
+char* __format_record(log_category_t _cat, log_lvl_e _lvl, const char* _format, va_list _args,
+    size_t* _len);
+/**
+ * @brief Formats message after `_head_len` bytes of header already placed in `__tls_record`,
+ *        terminating it with newline - see `__format_record`
+ */
+char* __format_body(size_t _head_len, const char* _format, va_list _args, size_t* _len);
+/**
+ * @brief Assembles binary record (`LOG_FORMAT_BINARY`) in `__tls_record` or in heap -
+ *        deferred if format string allows it, preformatted otherwise
+ * @return Record (must be freed if it is not `__tls_record`), or `NULL` on error
+ */
+char* __encode_record(log_category_t _cat, log_lvl_e _lvl, const char* _format, va_list _args,
+    size_t* _len);
+/**
+ * @brief Copies `_size` bytes of `_data` to `_out` at `*_len` if they fit in `_cap`,
+ *        and advances `*_len` regardless
+ */
+void __encode_put(char* _out, size_t _cap, size_t* _len, const void* _data, size_t _size);
+/**
+ * @brief Stores raw arguments consumed by `_info` in `_out`
+ * @return Count of bytes needed (nothing past `_cap` is written)
+ */
+size_t __encode_args(char* _out, size_t _cap, const __fmt_info_t* _info, va_list _args);
+/**
+ * @brief Parses conversion specification starting at `_p` (pointing at `%`)
+ * @return Pointer past specification
+ */
+const char* __fmt_parse(const char* _p, __fmt_spec_t* _spec);
+/**
+ * @brief Finds format string `_format` in registry, registering it if needed
+ * @return `NULL` if registry is full, or memory cannot be allocated
+ */
+__fmt_info_t* __fmt_lookup(const char* _format);
+/**
+ * @brief Commits definition record of `_info` to LOG file
+ */
+void __fmt_define(__fmt_info_t* _info);
+/**
+ * @brief Frees all format strings in registry - only once writers left (see `__writer_quiesce`),
+ *        as `__encode_record` looks them up and inserts them without locks
+ */
+void __fmt_clear(void);
+/**
+ * @brief Renders arguments `_args` of deferred message using `_format` to `_out`
+ * @return `false` if arguments are shorter than format string requires
+ */
+bool __decode_message(FILE* _out, const char* _format, const char* _args, size_t _size);
+/**
+ * @brief Copies `_n` bytes of `_args` at `*_at` to `_out`, if `_size` allows it
+ */
+bool __decode_take(const char* _args, size_t _size, size_t* _at, void* _out, size_t _n);
+/**
+ * @brief Commits `_record` to LOG file, according to `__mode`
+ */
+log_res_e __commit_record(const char* _record, size_t _len);
+/**
+ * @brief Writes `_record` directly to LOG file using single `write`, under `__write_mux`
+ */
+log_res_e __log_write(const char* _record, size_t _len);
+/**
+ * @brief Pushes `_record` to ring of calling thread
+ */
+log_res_e __log_enqueue(const char* _record, size_t _len);
+/**
+ * @brief Returns state of calling thread, creating and registering it if needed
+ * @return `NULL` if state cannot be allocated
+ */
+__thread_ctx_t* __thread_ctx(void);
+/**
+ * @brief Destructor of `__ctx_key` - marks state of exiting thread as orphaned
+ */
+void __thread_ctx_exit(void* _ctx);
+/**
+ * @brief Pushes `_len` bytes of `_record` to ring of `_ctx`, without blocking
+ */
+log_res_e __ring_push(__thread_ctx_t* _ctx, const char* _record, size_t _len);
+/**
+ * @brief Drains all rings to LOG file using batched `writev`, and frees orphaned states
+ * @return Count of bytes drained
+ */
+size_t __flush_rings(void);
+/**
+ * @brief Writes all `_cnt` buffers of `_iov` to `_fd`, retrying on partial writes
+ */
+log_res_e __writev_all(int _fd, struct iovec* _iov, int _cnt);
+/**
+ * @brief Prepares per-thread state registry and launches flusher thread
+ */
+log_res_e __flush_start(void);
+/**
+ * @brief Stops flusher thread, drains remaining messages and frees per-thread states
+ */
+void __flush_stop(void);
 
-log_res_e log_init(const char* _path)
-{
-    if (EBUSY == pthread_mutex_trylock(&__init_mux)
-        || __init_ready == true)
-    {
-        return LOG_RES_ERROR_DUP;
-    }
+/**
+ * @brief Writes definition records of all registered format strings to `_fd`
+ * @return Count of bytes written
+ */
+size_t __fmt_write_all(int _fd);
+/**
+ * @brief Counts `_written` bytes of current LOG file, and rotates it if it is due -
+ *        must be called only by writer (under `__write_mux`, or by flusher thread)
+ */
+void __rotate_check(size_t _written);
+/**
+ * @brief Starts new LOG file, and hands current one over to rotation thread
+ */
+void __rotate(void);
+/**
+ * @brief Launches rotation thread, if rotation is configured
+ */
+log_res_e __rotate_start(void);
+/**
+ * @brief Stops rotation thread, after it processes all queued LOG files
+ */
+void __rotate_stop(void);
+/**
+ * @brief Compresses `_path` to `_path`.gz, removing `_path` on success
+ */
+bool __rotate_gzip(const char* _path);
+/**
+ * @brief Removes oldest rotated LOG files of process above retention limits -
+ *        files not older than `_current` are never removed
+ */
+void __rotate_retain(const char* _current);
+/**
+ * @brief `Runnable` for syncing, compressing and removing rotated LOG files
+ */
+void* __rotate_thread(void* _);
+/**
+ * @brief Stops writer specific to `__mode` - flusher thread, or LOG file mapping
+ */
+void __writer_stop(void);
+/**
+ * @brief Prepares chunk mappings of LOG file and maps first chunk
+ */
+log_res_e __mmap_start(void);
+/**
+ * @brief Syncs and unmaps all chunks, and truncates LOG file to its real length -
+ *        once writers that may still copy into chunks left (see `__writer_quiesce`)
+ */
+void __mmap_stop(void);
+/**
+ * @brief Reserves space in mapped LOG file and copies `_record` into it, without locks
+ */
+log_res_e __mmap_write(const char* _record, size_t _len);
+/**
+ * @brief Returns mapping of chunk `_idx`, preallocating and mapping it if needed
+ * @return `NULL` if chunk cannot be mapped
+ */
+char* __mmap_map(size_t _idx);
+/**
+ * @brief Marks `_len` bytes of chunk `_idx` as copied, retiring chunk once it is full
+ */
+void __mmap_commit(size_t _idx, size_t _len);
+/**
+ * @brief `msync`s mapped LOG file from `_from` to `_to` offset
+ */
+void __mmap_msync(size_t _from, size_t _to);
+/**
+ * @brief Applies durability policy after record at `_offset` of `_len` bytes was copied
+ */
+void __mmap_sync_after(size_t _offset, size_t _len);
+
+/**
+ * @brief `Runnable` for draining per-thread rings to LOG file
+ */
+void* __flush_thread(void* _);
+/**
+ * @brief `Runnable` for creating DUMP files
+ */
+void* __dump_thread(void* _);
+/**
+ * @brief Signal action for changing LOG level
+ */
+void __log_action(int _signal, siginfo_t* _info, void* _);
+/**
+ * @brief Signal action for ordering DUMP files
+ */
+void __dump_action(int _signal, siginfo_t* _info, void* _);
+/**
+ * @brief Signal action for changing durability policy
+ */
+void __sync_action(int _signal, siginfo_t* _info, void* _);
+/**
+ * @brief Signal action for ordering snapshot of self-instrumentation counters
+ */
+void __stats_action(int _signal, siginfo_t* _info, void* _);
+
+/**
+ * @brief Installs crash handler for `__crash_signals`, and alternate signal stack
+ *        of calling thread
+ */
+void __crash_start(void);
+/**
+ * @brief Restores actions of `__crash_signals` replaced by `__crash_start`
+ */
+void __crash_stop(void);
+/**
+ * @brief Gives calling thread alternate signal stack, if it has none yet
+ */
+void __crash_altstack(void);
+/**
+ * @brief Signal action of fatal signals - writes pending messages, crash DUMP
+ *        and crash record, then raises signal again with default action
+ */
+void __crash_action(int _signal, siginfo_t* _info, void* _);
+/**
+ * @brief Writes messages pending in per-thread rings, without locking - async-signal-safe
+ */
+void __crash_flush(void);
+/**
+ * @brief Creates crash DUMP file, with backtrace of calling thread and memory map -
+ *        async-signal-safe (once `backtrace` was called before)
+ * @return Whether file was created, with its path in `_path` (at least `PATH_MAX` bytes)
+ */
+bool __crash_dump(const char* _signal_name, const siginfo_t* _info, char* _path);
+/**
+ * @brief Converts `_sec` to local time using `__crash_gmtoff` - async-signal-safe
+ */
+void __crash_tm(time_t _sec, struct tm* _tm);
+/**
+ * @brief Sets up io_uring with `LOG_URING_ENTRIES` entries, using raw system calls
+ * @return LOG_RES_SUCCESS, or LOG_RES_ERROR_OTHER if io_uring is unavailable
+ */
+log_res_e __uring_setup(__uring_t* _ring);
+/**
+ * @brief Unmaps and closes io_uring - it is left unused (`fd` == -1)
+ */
+void __uring_teardown(__uring_t* _ring);
+/**
+ * @brief Registers `_fd` as fixed file 0 of `_ring`, replacing previous one
+ * @return Whether `_fd` is registered
+ */
+bool __uring_register_file(__uring_t* _ring, int _fd);
+/**
+ * @brief Registers `_buf` as fixed buffer 0 of `_ring`
+ * @return Whether `_buf` is registered
+ */
+bool __uring_register_buffer(__uring_t* _ring, const char* _buf, size_t _size);
+/**
+ * @brief Writes `_iov` to `_fd` at its current offset, followed by linked `fsync`
+ *        (or `fdatasync`) if `_sync`, with single submission - registered file and buffer
+ *        are used if `_fd` and `_iov` are registered. Short write is completed with `writev`.
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_FILE - error while writing after some bytes were written
+ * @return LOG_RES_ERROR_OTHER - io_uring failed, and nothing was written
+ */
+log_res_e __uring_write(__uring_t* _ring, int _fd, struct iovec* _iov, int _cnt,
+    bool _sync, bool _data_only);
+/**
+ * @brief Writes batch of flusher thread with io_uring - for `_last` batch of pass, sync
+ *        due after `_messages` is linked after write. If io_uring fails, it is given up,
+ *        and batch is written with `writev`.
+ * @return Whether durability policy was applied
+ */
+bool __flush_submit(struct iovec* _iov, int _cnt, bool _last, size_t _messages);
+/**
+ * @brief Writes record to LOG file of instance, under its mutex
+ */
+log_res_e __instance_write(log_t* _log, const char* _record, size_t _len);
+/**
+ * @brief Creates LOG file of instance, and places lock on it
+ * @return `File descriptor` of created file, or -1 on error
+ */
+int __instance_open_file(const log_t* _log);
+/**
+ * @brief Creates queue of DUMP orders and its eventfd, and launches DUMP thread
+ */
+log_res_e __dump_start(void);
+/**
+ * @brief Registers `__fork_prepare`, `__fork_parent` and `__fork_child` - run once
+ */
+void __fork_register(void);
+/**
+ * @brief Fork handler - holds all mutexes, so that child inherits consistent LOG file state
+ */
+void __fork_prepare(void);
+/**
+ * @brief Fork handler - releases mutexes held by `__fork_prepare`
+ */
+void __fork_parent(void);
+/**
+ * @brief Fork handler - releases mutexes, resets counters, and reinitializes logging of child,
+ *        since only forking thread survives fork
+ */
+void __fork_child(void);
+/**
+ * @brief Gives child its own control block, threads and (unless shared) LOG file
+ */
+log_res_e __fork_reinit(void);
+/**
+ * @brief Fills set of control signals
+ */
+void __signal_set(sigset_t* _set);
+/**
+ * @brief Creates `signalfd` and `epoll` instance, and launches control thread
+ */
+log_res_e __signal_start(void);
+/**
+ * @brief Stops control thread, and closes its descriptors
+ */
+void __signal_stop(void);
+/**
+ * @brief `Runnable` servicing control signals in `LOG_SIGNALS_THREAD`
+ */
+void* __signal_thread(void* _);
+/**
+ * @brief Runs signal action of `_signal` on control thread, then does work that
+ *        is not async-signal-safe (recording change in LOG file)
+ */
+void __signal_dispatch(const struct signalfd_siginfo* _info);
+
+/**
+ * @brief Signal action for doorbell of control block
+ */
+void __control_action(int _signal, siginfo_t* _info, void* _);
+
+/**
+ * @brief Moves control block to POSIX shared memory, so that other processes can change it -
+ *        keeps using local one if shared memory is unavailable
+ */
+void __control_share(void);
+/**
+ * @brief Moves control block back to `__control_local`, and removes name of shared one
+ */
+void __control_unshare(void);
+/**
+ * @brief Records change of control block, ordered by `_cmd`, in LOG file
+ */
+void __control_report(const __dump_cmd_t* _cmd, unsigned _coalesced);
+/**
+ * @brief Creates tail ring of `_records` slots in POSIX shared memory
+ */
+log_res_e __tail_start(unsigned _records);
+/**
+ * @brief Stops publishing to tail ring, and removes its name
+ */
+void __tail_stop(void);
+/**
+ * @brief Returns slot of tail ring `_head` for record at `_pos`
+ */
+__tail_slot_t* __tail_slot(const __tail_head_t* _head, uint64_t _pos);
+/**
+ * @brief Copies `_record` to tail ring, unless its slot is still written by lapped writer -
+ *        never blocks
+ */
+void __tail_publish(const char* _record, size_t _len);
+
+/**
+ * @brief Returns counters of calling thread, acquiring block for it if needed
+ */
+__stats_t* __stats_local(void);
+/**
+ * @brief Creates `__stats_key` - run once
+ */
+void __stats_key_create(void);
+/**
+ * @brief Destructor of `__stats_key` - releases block of exiting thread for reuse
+ */
+void __stats_exit(void* _stats);
+/**
+ * @brief Adds `_value` to counter owned by calling thread - plain store, without bus lock
+ */
+void __stats_add(atomic_ullong* _counter, unsigned long long _value);
+/**
+ * @brief Counts outcome of single message in counters of calling thread
+ * @return `_res`
+ */
+log_res_e __stats_result(log_res_e _res, size_t _len);
+/**
+ * @brief Returns nanoseconds elapsed since `_since`, and sets `_since` to current time
+ */
+unsigned long long __stats_lap(struct timespec* _since);
+/**
+ * @brief Adds sample of `_ns` nanoseconds to `_hist` owned by calling thread
+ */
+void __stats_record(__stats_hist_t* _hist, unsigned long long _ns);
+/**
+ * @brief Adds counts of `_hist` to `_sum`
+ */
+void __stats_hist_sum(log_stats_hist_t* _sum, const __stats_hist_t* _hist);
+/**
+ * @brief Writes summary and non-empty buckets of `_hist` to STATS file
+ */
+void __stats_hist_print(__dump_writer_t* _writer, const char* _name, const log_stats_hist_t* _hist);
+
+
+//============================================================================//
+
+
+log_res_e log_init(const char* _path, const log_config_t* _config)
+{
+    if (EBUSY == pthread_mutex_trylock(&__init_mux)
+        || __init_ready == true)
+    {
+        return LOG_RES_ERROR_DUP;
+    }
+
+    log_res_e ret = LOG_RES_ERROR_ARG;
+    __errno = errno;
+    log_config_t config = { 0 };
+    if (_config != NULL) { config = *_config; }
+    if ((config.mode != LOG_MODE_SYNC && config.mode != LOG_MODE_ASYNC && config.mode != LOG_MODE_MMAP)
+        || config.timestamp < LOG_TS_SEC || config.timestamp > LOG_TS_MONOTONIC
+        || (config.format != LOG_FORMAT_TEXT && config.format != LOG_FORMAT_BINARY)
+        || (config.kv_format != LOG_KV_JSON && config.kv_format != LOG_KV_LOGFMT)
+        || (config.max_record != 0 && config.max_record < LOG_MIN_MAX_RECORD)
+        || (config.mode == LOG_MODE_MMAP && (config.rotate_bytes || config.rotate_interval_s))
+        || config.tail_records > LOG_TAIL_MAX_RECORDS
+        || (config.signals != LOG_SIGNALS_ACTION && config.signals != LOG_SIGNALS_THREAD)
+        || (config.shared && (config.mode == LOG_MODE_MMAP || config.format == LOG_FORMAT_BINARY
+            || config.rotate_bytes || config.rotate_interval_s)))
+    { goto error_init; }
+    __mode = config.mode;
+    __signals = config.signals;
+    __shared = config.shared;
+    __io_uring = config.io_uring;
+    __crash_enabled = config.crash_handler;
+    pthread_once(&__fork_once, __fork_register);
+    __ts_mode = config.timestamp;
+    __format = config.format;
+    __kv_format = config.kv_format;
+    atomic_store(&__kv_seq, 0);
+    __max_record = config.max_record ? config.max_record : LOG_DEFAULT_MAX_RECORD;
+    atomic_store(&__control->rotate_bytes, config.rotate_bytes);
+    atomic_store(&__control->rotate_interval_s, config.rotate_interval_s);
+    __rotate_compress = config.rotate_compress;
+    __retain_segments = config.retain_segments;
+    __retain_bytes = config.retain_bytes;
+    // Round ring capacity up to power of 2, so that indices can be masked
+    size_t ring_size = config.ring_size ? config.ring_size : LOG_DEFAULT_RING_SIZE;
+    __ring_size = LOG_MIN_RING_SIZE;
+    while (__ring_size < ring_size) { __ring_size <<= 1; }
+    __flush_interval_ms = config.flush_interval_ms
+        ? config.flush_interval_ms : LOG_DEFAULT_FLUSH_INTERVAL_MS;
+    unsigned rate_burst = config.rate_burst ? config.rate_burst : config.rate_limit;
+    __rate_interval_ns = config.rate_limit ? 1000000000ULL / config.rate_limit : 0;
+    __rate_burst_ns = rate_burst ? (rate_burst - 1) * __rate_interval_ns : 0;
+    __collapse = config.collapse_repeats;
+    // Round flight recorder ring up to power of 2, so that positions can be masked
+    __flight_size = 0;
+    if (config.flight_size != 0)
+    {
+        __flight_size = LOG_MIN_FLIGHT_SIZE;
+        while (__flight_size < config.flight_size) { __flight_size <<= 1; }
+    }
+    // Round chunk size up to page size, so that chunks can be mapped at their offsets
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mmap_chunk = config.mmap_chunk ? config.mmap_chunk : LOG_DEFAULT_MMAP_CHUNK;
+    __mmap_chunk = (mmap_chunk + page_size - 1) / page_size * page_size;
+    int sync_cfg = __sync_pack(config.sync, config.sync_param);
+    if (sync_cfg < 0) { goto error_init; }
+    __control->sync = sync_cfg;
+    __sync_pending = 0;
+    clock_gettime(CLOCK_MONOTONIC, &__sync_last);
 
     if (_path == NULL) { __path = "."; }
     else
@@ -104,7 +1668,11 @@ log_res_e log_init(const char* _path)
         // Check if path exists
         DIR* path_dir = opendir(_path);
         if (path_dir) { closedir(path_dir); }
-        else { return LOG_RES_ERROR_ARG; }
+        else
+        {
+            __errno = errno;
+            goto error_init;
+        }
         __path = _path;
     }
 
@@ -114,22 +1682,25 @@ log_res_e log_init(const char* _path)
     __path_len = path_len; 
   
     // Create LOG file
-    char* log_path = __create_file_name("LOG");
-    __log_fd = open(log_path, O_CREAT | O_RDWR,
-        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_ISGID);
-    __errno = errno;
-    free(log_path);
+    __log_fd = __open_log_file(&__log_base);
     if (__log_fd < 0)
     {
-        errno = __errno;
-        return LOG_RES_ERROR_FILE;
+        __errno = errno;
+        ret = LOG_RES_ERROR_FILE;
+        goto error_init;
     }
- 
+    __log_bytes = __log_base;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    __rotate_since = now.tv_sec;
+
     // Check if mandatory locking is enabled
     // if not - attempt to remount filesystem to enable it
     // if remounting fails (requires elevated permissions), proceed without erroring
+    // (shared LOG file is never locked)
     struct statfs sfs;
-    if (statfs("/", &sfs) == 0
+    if (!__shared
+        && statfs("/", &sfs) == 0
         && (sfs.f_flags & MS_MANDLOCK) == 0)
     {
         if (mount("/", "/", NULL, MS_REMOUNT | MS_MANDLOCK, NULL) != 0
@@ -142,384 +1713,5371 @@ log_res_e log_init(const char* _path)
                 "\33[0m"
             );
 
-        }
+        }
+    }
+
+    // Lock LOG file
+    if ((ret = __change_file_lock(__log_fd, true)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_file;
+    }
+
+    // Threads of library inherit mask of calling thread - block before first of them is launched,
+    // and keep original mask to restore it if initialization fails
+    sigset_t sset, smask;
+    __signal_set(&sset);
+    if (__signals == LOG_SIGNALS_THREAD) { pthread_sigmask(SIG_BLOCK, &sset, &smask); }
+    else { pthread_sigmask(SIG_BLOCK, NULL, &smask); }
+
+    // Create queue of DUMP orders, and launch DUMP thread
+    if ((ret = __dump_start()) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_mask;
+    }
+
+    // Launch flusher thread for asynchronous mode, or map LOG file for memory-mapped mode
+    if (__mode == LOG_MODE_ASYNC) { ret = __flush_start(); }
+    else if (__mode == LOG_MODE_MMAP) { ret = __mmap_start(); }
+    if (ret != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_dump;
+    }
+    // Launch thread compressing rotated LOG files
+    if ((ret = __rotate_start()) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_writer;
+    }
+
+    // Publish control block - failure leaves only signals for communication
+    __control_share();
+    // Publish tail ring - failure is reported once LOG file is ready
+    log_res_e tail_ret = LOG_RES_SUCCESS;
+    if (config.tail_records && __format == LOG_FORMAT_TEXT) { tail_ret = __tail_start(config.tail_records); }
+
+    // Unlock signals used for communication, unless they are serviced by control thread
+    if (__signals == LOG_SIGNALS_ACTION) { pthread_sigmask(SIG_UNBLOCK, &sset, NULL); }
+
+    // Set signal handlers - also in `LOG_SIGNALS_THREAD`, for threads that did not block signals
+    if ((ret = __register_signal(SIGLOG, __log_action)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_control;
+    }
+    if ((ret = __register_signal(SIGDUMP, __dump_action)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_siglog;
+    }
+    if ((ret = __register_signal(SIGSYNC, __sync_action)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_sigdump;
+    }
+    if ((ret = __register_signal(SIGSTAT, __stats_action)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_sigsync;
+    }
+    if ((ret = __register_signal(SIGCTL, __control_action)) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_sigstat;
+    }
+    if (__signals == LOG_SIGNALS_THREAD && (ret = __signal_start()) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        goto error_sigctl;
+    }
+
+    if (__crash_enabled) { __crash_start(); }
+    __init_ready = true;
+    atomic_store(&__writers_open, true);
+    __log_set_level(LOG_MAX_CATEGORIES, LOG_LVL_MAX);
+    __log_capture = __flight_size != 0 ? LOG_LVL_MAX + 1 : 0;
+    if (tail_ret != LOG_RES_SUCCESS)
+    {
+        log_printf(LOG_LVL_MIN, "Failed to create tail ring: error code [%d]", tail_ret);
+    }
+    pthread_mutex_unlock(&__init_mux);
+    return LOG_RES_SUCCESS;
+
+    // Undo steps in reverse order - every label undoes step that succeeded before failed one
+error_sigctl:
+    __register_signal(SIGCTL, NULL);
+error_sigstat:
+    __register_signal(SIGSTAT, NULL);
+error_sigsync:
+    __register_signal(SIGSYNC, NULL);
+error_sigdump:
+    __register_signal(SIGDUMP, NULL);
+error_siglog:
+    __register_signal(SIGLOG, NULL);
+error_control:
+    __control_unshare();
+    __tail_stop();
+error_writer:
+    // Writer drains rings into, or truncates, LOG file - it must still be open
+    __writer_stop();
+error_dump:
+    __dump_stop();
+    close(__dump_event);
+error_mask:
+    pthread_sigmask(SIG_SETMASK, &smask, NULL);
+    __change_file_lock(__log_fd, false);
+error_file:
+    close(__log_fd);
+error_init:
+    pthread_mutex_unlock(&__init_mux);
+    errno = __errno;
+    return ret;
+}
+
+
+log_res_e log_deinit(void)
+{
+    if (EBUSY == pthread_mutex_trylock(&__init_mux)
+        || __init_ready == false)
+    {
+        return LOG_RES_ERROR_DUP;
+    }
+
+    // Remove signal handlers
+    __register_signal(SIGLOG, NULL);
+    __register_signal(SIGDUMP, NULL);
+    __register_signal(SIGSYNC, NULL);
+    __register_signal(SIGSTAT, NULL);
+    __register_signal(SIGCTL, NULL);
+    if (__signals == LOG_SIGNALS_THREAD) { __signal_stop(); }
+    if (__crash_enabled) { __crash_stop(); }
+
+    // Threads that passed level check may still be writing - rings and other state of writers
+    // are torn down only once they all left
+    __writer_quiesce();
+    // No thread can add to counts of rate limit and collapsing anymore - all of them are printed
+    // while logging is still on, as last writer
+    __rate_flush(NULL, false);
+    __log_set_level(LOG_MAX_CATEGORIES, LOG_LVL_OFF);
+    __log_capture = 0;
+
+    // Stop DUMP thread
+    __dump_stop();
+
+    // Drain rings and stop flusher thread, or unmap and truncate LOG file,
+    // then wait for rotation thread to process rotated LOG files
+    __writer_stop();
+
+    // Unlock LOG file
+    __change_file_lock(__log_fd, false);
+
+    // Close LOG file
+    close(__log_fd);
+
+    // Forget format strings - next LOG file has to define them again
+    // (writers were quiesced above, so nobody is looking them up)
+    __fmt_clear();
+
+    // Close eventfd of DUMP queue
+    close(__dump_event);
+
+    // Withdraw control block - later changes of settings do not outlive `deinit`
+    __control_unshare();
+    __tail_stop();
+
+    __init_ready = false;
+    pthread_mutex_unlock(&__init_mux);
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e (log_printf)(log_lvl_e _lvl, const char* _format, ...)
+{
+    va_list format_args;
+    va_start(format_args, _format);
+    log_res_e ret = __log_vprintf(&__log_default, LOG_CATEGORY_DEFAULT, _lvl, _format, format_args);
+    va_end(format_args);
+    return ret;
+}
+
+
+log_res_e log_category_register(const char* _name, log_category_t* _id)
+{
+    if (_name == NULL || _id == NULL) { return LOG_RES_ERROR_ARG; }
+
+    pthread_mutex_lock(&__category_mux);
+    unsigned count = atomic_load(&__category_count);
+    for (unsigned i = 1; i < count; ++i)
+    {
+        if (strncmp(__category_names[i], _name, LOG_CATEGORY_NAME_SIZE - 1) == 0)
+        {
+            pthread_mutex_unlock(&__category_mux);
+            *_id = i;
+            return LOG_RES_SUCCESS;
+        }
+    }
+    if (count == LOG_MAX_CATEGORIES)
+    {
+        pthread_mutex_unlock(&__category_mux);
+        return LOG_RES_ERROR_ARG;
+    }
+
+    snprintf(__category_names[count], LOG_CATEGORY_NAME_SIZE, "%s", _name);
+    __log_enabled[count] = __log_enabled[LOG_CATEGORY_DEFAULT];
+    // Publish category only after its name and level are set
+    atomic_store(&__category_count, count + 1);
+    if (__init_ready && __format == LOG_FORMAT_BINARY && __writer_enter())
+    {
+        __category_define(count);
+        __writer_leave();
+    }
+    pthread_mutex_unlock(&__category_mux);
+
+    *_id = count;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e (log_category_printf)(log_category_t _cat, log_lvl_e _lvl, const char* _format, ...)
+{
+    if (_cat >= atomic_load_explicit(&__category_count, memory_order_acquire))
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    va_list format_args;
+    va_start(format_args, _format);
+    log_res_e ret = __log_vprintf(&__log_default, _cat, _lvl, _format, format_args);
+    va_end(format_args);
+    return ret;
+}
+
+
+log_res_e log_open(const char* _name, const log_config_t* _config, log_t** _log)
+{
+    if (_name == NULL || _log == NULL) { return LOG_RES_ERROR_ARG; }
+    size_t name_len = strlen(_name);
+    if (name_len >= LOG_INSTANCE_NAME_SIZE || !isalpha((unsigned char)_name[0]))
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+    for (size_t i = 0; i < name_len; ++i)
+    {
+        if (!isalnum((unsigned char)_name[i]) && _name[i] != '-' && _name[i] != '_')
+        {
+            return LOG_RES_ERROR_ARG;
+        }
+    }
+    log_config_t config = { 0 };
+    if (_config != NULL) { config = *_config; }
+    int sync_cfg = __sync_pack(config.sync, config.sync_param);
+    if (sync_cfg < 0) { return LOG_RES_ERROR_ARG; }
+
+    // Path and format of records are settled by `log_init`
+    if (__init_ready == false) { return LOG_RES_ERROR_DUP; }
+
+    log_t* log = (log_t*)calloc(1, sizeof(log_t));
+    if (log == NULL) { return LOG_RES_ERROR_OTHER; }
+    memcpy(log->name, _name, name_len + 1);
+    log->sync = sync_cfg;
+    clock_gettime(CLOCK_MONOTONIC, &log->sync_last);
+    if ((log->fd = __instance_open_file(log)) < 0)
+    {
+        __errno = errno;
+        free(log);
+        errno = __errno;
+        return LOG_RES_ERROR_FILE;
+    }
+    pthread_mutex_init(&log->mux, NULL);
+    atomic_init(&log->pins, 0);
+
+    pthread_mutex_lock(&__instances_mux);
+    log->next = __instances;
+    __instances = log;
+    pthread_mutex_unlock(&__instances_mux);
+
+    *_log = log;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_close(log_t* _log)
+{
+    if (_log == NULL || _log == &__log_default) { return LOG_RES_ERROR_ARG; }
+
+    // Counts of all threads are printed while instance is still open
+    if (__writer_enter())
+    {
+        __rate_flush(_log, false);
+        __writer_leave();
+    }
+    pthread_mutex_lock(&__instances_mux);
+    log_t** link = &__instances;
+    while (*link != NULL && *link != _log) { link = &(*link)->next; }
+    if (*link == NULL)
+    {
+        pthread_mutex_unlock(&__instances_mux);
+        return LOG_RES_ERROR_ARG;
+    }
+    *link = _log->next;
+    pthread_mutex_unlock(&__instances_mux);
+    // Notices already printed to instance are finished - new ones no longer find it
+    while (atomic_load(&_log->pins) != 0) { sched_yield(); }
+
+    __sync_file(_log->fd, __sync_pack(LOG_SYNC_MESSAGE, 0), &_log->sync_pending, &_log->sync_last, 0);
+    __change_file_lock(_log->fd, false);
+    close(_log->fd);
+    pthread_mutex_destroy(&_log->mux);
+    free(_log);
+    return LOG_RES_SUCCESS;
+}
+
+
+log_t* log_default(void)
+{
+    return &__log_default;
+}
+
+
+log_res_e (log_instance_printf)(log_t* _log, log_category_t _cat, log_lvl_e _lvl,
+    const char* _format, ...)
+{
+    if (_log == NULL || _cat >= atomic_load_explicit(&__category_count, memory_order_acquire))
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    va_list format_args;
+    va_start(format_args, _format);
+    log_res_e ret = __log_vprintf(_log, _cat, _lvl, _format, format_args);
+    va_end(format_args);
+    return ret;
+}
+
+
+log_res_e log_fields(log_category_t _cat, log_lvl_e _lvl, const char* _msg,
+    const log_field_t* _fields, size_t _count)
+{
+    static const char* lvl_names[] = { "MIN", "STD", "MAX" };
+    if (_cat >= atomic_load_explicit(&__category_count, memory_order_acquire))
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+    if (LOG_LVL_MIN > _lvl || _lvl > LOG_LVL_MAX) { return LOG_RES_ERROR_OTHER; }
+    if (__log_enabled[_cat] == 0) { return __stats_result(LOG_RES_OFF, 0); }
+    if (__log_enabled[_cat] <= _lvl) { return __stats_result(LOG_RES_IGNORED, 0); }
+    if (!__writer_enter()) { return __stats_result(LOG_RES_OFF, 0); }
+    __rate_state_t* rate = __tls_rate;
+    if (rate != NULL && atomic_load_explicit(&rate->repeat.repeated, memory_order_relaxed) != 0)
+    {
+        __repeat_report(&rate->repeat);
+    }
+
+    struct timespec mono;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    if (__tls_tid == 0) { __tls_tid = (pid_t)syscall(__NR_gettid); }
+    bool json = __kv_format == LOG_KV_JSON;
+
+    // Binary record header is filled in once length is known
+    __kv_buf_t buf = {
+        .data = __tls_record,
+        .len = __format == LOG_FORMAT_BINARY ? sizeof(__rec_head_t) : 0,
+        .cap = sizeof(__tls_record) < __max_record ? sizeof(__tls_record) : __max_record,
+        .overflow = false,
+    };
+
+    // Fixed fields always fit in `__tls_record`
+    char ts[32];
+    size_t ts_len = __format_timestamp(ts);
+    if (json) { __kv_put(&buf, "{", 1); }
+    __kv_put_key(&buf, "time");
+    __kv_put(&buf, "\"", json || __ts_mode != LOG_TS_MONOTONIC);
+    __kv_put(&buf, ts, ts_len);
+    __kv_put(&buf, "\"", json || __ts_mode != LOG_TS_MONOTONIC);
+    __kv_put(&buf, json ? "," : " ", 1);
+    __kv_put_key(&buf, "mono_ns");
+    __kv_put_uint(&buf, (unsigned long long)mono.tv_sec * 1000000000ULL + (unsigned long long)mono.tv_nsec, false);
+    __kv_put(&buf, json ? "," : " ", 1);
+    __kv_put_key(&buf, "seq");
+    __kv_put_uint(&buf, atomic_fetch_add_explicit(&__kv_seq, 1, memory_order_relaxed) + 1, false);
+    __kv_put(&buf, json ? "," : " ", 1);
+    __kv_put_key(&buf, "tid");
+    __kv_put_uint(&buf, (unsigned long long)__tls_tid, false);
+    __kv_put(&buf, json ? "," : " ", 1);
+    __kv_put_key(&buf, "lvl");
+    __kv_put_str(&buf, lvl_names[_lvl]);
+    if (_cat != LOG_CATEGORY_DEFAULT)
+    {
+        __kv_put(&buf, json ? "," : " ", 1);
+        __kv_put_key(&buf, "cat");
+        __kv_put_str(&buf, __category_names[_cat]);
+    }
+
+    // Message and fields are appended whole, or skipped if they do not fit
+    size_t dropped = 0;
+    for (size_t i = 0; i <= _count; ++i)
+    {
+        if (i == 0 && _msg == NULL) { continue; }
+        size_t mark = buf.len;
+        __kv_put(&buf, json ? "," : " ", 1);
+        if (i == 0)
+        {
+            __kv_put_key(&buf, "msg");
+            __kv_put_str(&buf, _msg);
+        }
+        else
+        {
+            __kv_put_key(&buf, _fields[i - 1].key);
+            __kv_put_value(&buf, &_fields[i - 1]);
+        }
+        if (buf.overflow)
+        {
+            buf.len = mark;
+            buf.overflow = false;
+            ++dropped;
+        }
+    }
+    if (dropped)
+    {
+        __kv_put(&buf, json ? "," : " ", 1);
+        __kv_put_key(&buf, "dropped_fields");
+        __kv_put_uint(&buf, dropped, false);
+    }
+    if (json) { __kv_put(&buf, "}", 1); }
+    __kv_put(&buf, "\n", 1);
+    if (buf.overflow)
+    {
+        if (buf.data != __tls_record) { free(buf.data); }
+        __writer_leave();
+        return __stats_result(LOG_RES_ERROR_OTHER, 0);
+    }
+
+    if (__format == LOG_FORMAT_BINARY)
+    {
+        __rec_head_t head = {
+            .len = (uint32_t)buf.len,
+            .type = __REC_RAW,
+            .lvl = (uint16_t)_lvl,
+            .category = (uint32_t)_cat,
+        };
+        memcpy(buf.data, &head, sizeof(head));
+    }
+    log_res_e ret = __stats_result(__commit_record(buf.data, buf.len), buf.len);
+    __writer_leave();
+    if (buf.data != __tls_record) { free(buf.data); }
+    return ret;
+}
+
+
+log_res_e log_dispatch_log_level(pid_t _pid, log_lvl_e _lvl)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    if (_lvl != LOG_LVL_OFF
+        && _lvl != LOG_LVL_MIN
+        && _lvl != LOG_LVL_STANDARD
+        && _lvl != LOG_LVL_MAX)
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    return __dispatch_signal(pid, SIGLOG, _lvl);
+}
+
+
+log_res_e log_dispatch_category_level(pid_t _pid, log_category_t _cat, log_lvl_e _lvl)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    if ((_lvl != LOG_LVL_OFF
+        && _lvl != LOG_LVL_MIN
+        && _lvl != LOG_LVL_STANDARD
+        && _lvl != LOG_LVL_MAX)
+        || _cat >= LOG_MAX_CATEGORIES)
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    // Category is shifted by 1, so that payload never collides with plain level
+    return __dispatch_signal(pid, SIGLOG,
+        (int)(((_cat + 1) << LOG_LVL_BITS) | ((unsigned)_lvl & ((1u << LOG_LVL_BITS) - 1))));
+}
+
+
+log_res_e log_dispatch_log_dump(pid_t _pid, log_dump_lvl_e _lvl)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    if (_lvl != LOG_DUMP_LVL_NORMAL
+        && _lvl != LOG_DUMP_LVL_DETAIL
+        && _lvl != LOG_DUMP_LVL_EXTENDED
+        && _lvl != LOG_DUMP_LVL_FULL)
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    return __dispatch_signal(pid, SIGDUMP, _lvl);
+}
+
+
+log_res_e log_dispatch_log_dump_sections(pid_t _pid, log_dump_lvl_e _lvl, unsigned _sections)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    if ((_lvl != LOG_DUMP_LVL_NORMAL
+        && _lvl != LOG_DUMP_LVL_DETAIL
+        && _lvl != LOG_DUMP_LVL_EXTENDED
+        && _lvl != LOG_DUMP_LVL_FULL)
+        || _sections > LOG_DUMP_SECTION_ALL)
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    return __dispatch_signal(pid, SIGDUMP, (int)(_lvl | (_sections << LOG_DUMP_LVL_BITS)));
+}
+
+
+log_res_e log_dispatch_sync_policy(pid_t _pid, log_sync_e _sync, unsigned _param)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    int value = __sync_pack(_sync, _param);
+    if (value < 0) { return LOG_RES_ERROR_ARG; }
+
+    return __dispatch_signal(pid, SIGSYNC, value);
+}
+
+
+log_res_e log_dispatch_stats(pid_t _pid)
+{
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    return __dispatch_signal(pid, SIGSTAT, 0);
+}
+
+
+log_res_e log_stats(log_stats_t* _stats)
+{
+    if (_stats == NULL) { return LOG_RES_ERROR_ARG; }
+
+    memset(_stats, 0, sizeof(*_stats));
+    for (__stats_t* stats = atomic_load_explicit(&__stats_list, memory_order_acquire);
+        stats != NULL;
+        stats = stats->next)
+    {
+        _stats->accepted += atomic_load_explicit(&stats->accepted, memory_order_relaxed);
+        _stats->ignored += atomic_load_explicit(&stats->ignored, memory_order_relaxed);
+        _stats->dropped += atomic_load_explicit(&stats->dropped, memory_order_relaxed);
+        _stats->suppressed += atomic_load_explicit(&stats->suppressed, memory_order_relaxed);
+        _stats->failed += atomic_load_explicit(&stats->failed, memory_order_relaxed);
+        _stats->bytes += atomic_load_explicit(&stats->bytes, memory_order_relaxed);
+        __stats_hist_sum(&_stats->write, &stats->write);
+        __stats_hist_sum(&_stats->sync, &stats->sync);
+        __stats_hist_sum(&_stats->lock_wait, &stats->lock_wait);
+        __stats_hist_sum(&_stats->dump, &stats->dump);
+    }
+    _stats->threads = atomic_load(&__stats_threads);
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_control_open(pid_t _pid, log_control_t** _ctl)
+{
+    if (_ctl == NULL) { return LOG_RES_ERROR_ARG; }
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    char name[sizeof(__control_name)];
+    snprintf(name, sizeof(name), LOG_CONTROL_NAME, (intmax_t)pid);
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) { return errno == ENOENT ? LOG_RES_ERROR_ARG : LOG_RES_ERROR_FILE; }
+    struct stat fd_stat;
+    if (fstat(fd, &fd_stat) != 0 || (size_t)fd_stat.st_size < sizeof(__control_t))
+    {
+        close(fd);
+        return LOG_RES_ERROR_ARG;
+    }
+    __control_t* block = (__control_t*)mmap(NULL, sizeof(__control_t),
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (block == MAP_FAILED) { return LOG_RES_ERROR_FILE; }
+    if (memcmp(block->magic, LOG_CONTROL_MAGIC, sizeof(block->magic)) != 0
+        || block->version != LOG_CONTROL_VERSION)
+    {
+        munmap(block, sizeof(__control_t));
+        return LOG_RES_ERROR_ARG;
+    }
+
+    log_control_t* ctl = (log_control_t*)malloc(sizeof(log_control_t));
+    if (ctl == NULL)
+    {
+        munmap(block, sizeof(__control_t));
+        return LOG_RES_ERROR_OTHER;
+    }
+    ctl->pid = pid;
+    ctl->block = block;
+    ctl->changed = false;
+    *_ctl = ctl;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_control_level(log_control_t* _ctl, log_category_t _cat, log_lvl_e _lvl)
+{
+    if (_ctl == NULL
+        || (_lvl != LOG_LVL_OFF
+            && _lvl != LOG_LVL_MIN
+            && _lvl != LOG_LVL_STANDARD
+            && _lvl != LOG_LVL_MAX)
+        || _cat > LOG_MAX_CATEGORIES)
+    {
+        return LOG_RES_ERROR_ARG;
+    }
+
+    if (_cat < LOG_MAX_CATEGORIES) { _ctl->block->enabled[_cat] = _lvl + 1; }
+    else
+    {
+        for (size_t i = 0; i < LOG_MAX_CATEGORIES; ++i) { _ctl->block->enabled[i] = _lvl + 1; }
+    }
+    atomic_fetch_add(&_ctl->block->generation, 1);
+    _ctl->changed = true;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_control_sync(log_control_t* _ctl, log_sync_e _sync, unsigned _param)
+{
+    int value = __sync_pack(_sync, _param);
+    if (_ctl == NULL || value < 0) { return LOG_RES_ERROR_ARG; }
+
+    _ctl->block->sync = value;
+    atomic_fetch_add(&_ctl->block->generation, 1);
+    _ctl->changed = true;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_control_rotation(log_control_t* _ctl, size_t _bytes, unsigned _interval_s)
+{
+    if (_ctl == NULL) { return LOG_RES_ERROR_ARG; }
+
+    atomic_store(&_ctl->block->rotate_bytes, _bytes);
+    atomic_store(&_ctl->block->rotate_interval_s, _interval_s);
+    atomic_fetch_add(&_ctl->block->generation, 1);
+    _ctl->changed = true;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_control_close(log_control_t* _ctl)
+{
+    if (_ctl == NULL) { return LOG_RES_ERROR_ARG; }
+
+    log_res_e ret = LOG_RES_SUCCESS;
+    if (_ctl->changed)
+    {
+        ret = __dispatch_signal(_ctl->pid, SIGCTL, (int)atomic_load(&_ctl->block->generation));
+    }
+    munmap(_ctl->block, sizeof(__control_t));
+    free(_ctl);
+    return ret;
+}
+
+
+log_res_e log_tail_open(pid_t _pid, unsigned _backlog, log_tail_t** _tail)
+{
+    if (_tail == NULL) { return LOG_RES_ERROR_ARG; }
+    pid_t pid;
+    if (_pid == 0) { pid = getpid(); }
+    else { pid = _pid; }
+
+    char name[sizeof(__tail_name)];
+    snprintf(name, sizeof(name), LOG_TAIL_NAME, (intmax_t)pid);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) { return errno == ENOENT ? LOG_RES_ERROR_ARG : LOG_RES_ERROR_FILE; }
+    struct stat fd_stat;
+    if (fstat(fd, &fd_stat) != 0 || (size_t)fd_stat.st_size < sizeof(__tail_head_t))
+    {
+        close(fd);
+        return LOG_RES_ERROR_ARG;
+    }
+    size_t size = (size_t)fd_stat.st_size;
+    const __tail_head_t* head = (const __tail_head_t*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (head == MAP_FAILED) { return LOG_RES_ERROR_FILE; }
+    if (memcmp(head->magic, LOG_TAIL_MAGIC, sizeof(head->magic)) != 0
+        || head->version != LOG_TAIL_VERSION
+        || head->slot_size != LOG_TAIL_SLOT_SIZE
+        || sizeof(__tail_head_t) + head->slots * LOG_TAIL_SLOT_SIZE > size)
+    {
+        munmap((void*)head, size);
+        return LOG_RES_ERROR_ARG;
+    }
+
+    log_tail_t* tail = (log_tail_t*)malloc(sizeof(log_tail_t));
+    if (tail == NULL)
+    {
+        munmap((void*)head, size);
+        return LOG_RES_ERROR_OTHER;
+    }
+    uint64_t pos = atomic_load_explicit(&head->head, memory_order_acquire);
+    uint64_t backlog = _backlog < head->slots ? _backlog : head->slots;
+    tail->head = head;
+    tail->size = size;
+    tail->pos = pos > backlog ? pos - backlog : 0;
+    tail->stall_pos = UINT64_MAX;
+    *_tail = tail;
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_tail_next(log_tail_t* _tail, char* _buf, size_t _cap, size_t* _len,
+    unsigned long long* _missed)
+{
+    if (_tail == NULL || _buf == NULL || _len == NULL || _missed == NULL) { return LOG_RES_ERROR_ARG; }
+
+    *_len = 0;
+    *_missed = 0;
+    while (true)
+    {
+        uint64_t head = atomic_load_explicit(&_tail->head->head, memory_order_acquire);
+        if (_tail->pos >= head) { return LOG_RES_SUCCESS; }
+        // Records lapped by writers are gone
+        if (head - _tail->pos > _tail->head->slots)
+        {
+            *_missed += head - _tail->head->slots - _tail->pos;
+            _tail->pos = head - _tail->head->slots;
+        }
+
+        __tail_slot_t* slot = __tail_slot(_tail->head, _tail->pos);
+        uint64_t done = 2 * _tail->pos + 2;
+        uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq == done)
+        {
+            size_t len = slot->len < sizeof(slot->data) ? slot->len : sizeof(slot->data);
+            if (len > _cap) { len = _cap; }
+            memcpy(_buf, slot->data, len);
+            // Copy is valid only if slot was not claimed by another writer meanwhile
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) { continue; }
+            ++_tail->pos;
+            *_len = len;
+            return LOG_RES_SUCCESS;
+        }
+        if (seq > done)
+        {
+            ++*_missed;
+            ++_tail->pos;
+            continue;
+        }
+
+        // Record is still written - skip it only if its writer stalls, or gave up on slot
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        if (_tail->stall_pos != _tail->pos)
+        {
+            _tail->stall_pos = _tail->pos;
+            _tail->stall_since = now;
+            return LOG_RES_SUCCESS;
+        }
+        long long stall_ms = (now.tv_sec - _tail->stall_since.tv_sec) * 1000LL
+            + (now.tv_nsec - _tail->stall_since.tv_nsec) / 1000000L;
+        if (stall_ms < LOG_TAIL_STALL_MS || head == _tail->pos + 1) { return LOG_RES_SUCCESS; }
+        ++*_missed;
+        ++_tail->pos;
+    }
+}
+
+
+log_res_e log_tail_close(log_tail_t* _tail)
+{
+    if (_tail == NULL) { return LOG_RES_ERROR_ARG; }
+
+    munmap((void*)_tail->head, _tail->size);
+    free(_tail);
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_decode(int _in_fd, int _out_fd)
+{
+    struct stat in_stat;
+    if (fstat(_in_fd, &in_stat) != 0) { return LOG_RES_ERROR_FILE; }
+    size_t size = (size_t)in_stat.st_size;
+    if (size < sizeof(__file_head_t)) { return LOG_RES_ERROR_ARG; }
+
+    const char* data = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, _in_fd, 0);
+    if (data == MAP_FAILED) { return LOG_RES_ERROR_FILE; }
+
+    __file_head_t file_head;
+    memcpy(&file_head, data, sizeof(file_head));
+    if (memcmp(file_head.magic, LOG_BINARY_MAGIC, sizeof(file_head.magic)) != 0
+        || file_head.version != LOG_BINARY_VERSION
+        || file_head.timestamp > LOG_TS_MONOTONIC)
+    {
+        munmap((void*)data, size);
+        return LOG_RES_ERROR_ARG;
+    }
+
+    // First pass - collect definitions, as messages of other threads may precede them
+    char** formats = NULL;
+    size_t formats_cnt = 0;
+    char categories[LOG_MAX_CATEGORIES][LOG_CATEGORY_NAME_SIZE] = { { 0 } };
+    __rec_head_t head;
+    for (size_t at = sizeof(file_head);
+        at + sizeof(head) <= size;
+        at += head.len)
+    {
+        memcpy(&head, data + at, sizeof(head));
+        if (head.len < sizeof(head) || head.len > size - at) { break; }
+        if (head.type == __REC_CAT && head.fmt_id < LOG_MAX_CATEGORIES)
+        {
+            size_t name_len = head.len - sizeof(head);
+            if (name_len >= LOG_CATEGORY_NAME_SIZE) { name_len = LOG_CATEGORY_NAME_SIZE - 1; }
+            memcpy(categories[head.fmt_id], data + at + sizeof(head), name_len);
+            categories[head.fmt_id][name_len] = '\0';
+        }
+        if (head.type != __REC_DEF) { continue; }
+
+        if (head.fmt_id >= formats_cnt)
+        {
+            size_t cnt = formats_cnt ? formats_cnt : 64;
+            while (cnt <= head.fmt_id) { cnt *= 2; }
+            char** grown = (char**)realloc(formats, cnt * sizeof(char*));
+            if (grown == NULL)
+            {
+                for (size_t i = 0; i < formats_cnt; ++i) { free(formats[i]); }
+                free(formats);
+                munmap((void*)data, size);
+                return LOG_RES_ERROR_OTHER;
+            }
+            memset(grown + formats_cnt, 0, (cnt - formats_cnt) * sizeof(char*));
+            formats = grown;
+            formats_cnt = cnt;
+        }
+        if (formats[head.fmt_id] == NULL)
+        {
+            formats[head.fmt_id] = strndup(data + at + sizeof(head), head.len - sizeof(head));
+            if (formats[head.fmt_id] == NULL)
+            {
+                for (size_t i = 0; i < formats_cnt; ++i) { free(formats[i]); }
+                free(formats);
+                munmap((void*)data, size);
+                return LOG_RES_ERROR_OTHER;
+            }
+        }
+    }
+
+    // Second pass - render messages
+    log_res_e ret = LOG_RES_SUCCESS;
+    int out_fd = dup(_out_fd);
+    FILE* out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+    if (out == NULL)
+    {
+        if (out_fd >= 0) { close(out_fd); }
+        ret = LOG_RES_ERROR_FILE;
+    }
+    for (size_t at = sizeof(file_head);
+        out != NULL && at + sizeof(head) <= size;
+        at += head.len)
+    {
+        memcpy(&head, data + at, sizeof(head));
+        if (head.len < sizeof(head) || head.len > size - at) { break; }
+        if (head.type == __REC_RAW)
+        {
+            fwrite(data + at + sizeof(head), 1, head.len - sizeof(head), out);
+            continue;
+        }
+        if (head.type != __REC_MSG && head.type != __REC_TEXT) { continue; }
+
+        char ts[32];
+        struct timespec ts_value = {
+            .tv_sec = (time_t)(head.ts_ns / 1000000000ULL),
+            .tv_nsec = (long)(head.ts_ns % 1000000000ULL),
+        };
+        size_t ts_len = __render_timestamp(ts, &ts_value, (log_ts_e)file_head.timestamp);
+        fprintf(out, "%s%.*s] ",
+            head.lvl <= LOG_LVL_MAX ? __lvl_tags[head.lvl] : "[??? @ ",
+            (int)ts_len, ts);
+        if (head.category >= LOG_MAX_CATEGORIES) { fprintf(out, "[#%" PRIu32 "] ", head.category); }
+        else if (head.category != LOG_CATEGORY_DEFAULT)
+        {
+            if (categories[head.category][0]) { fprintf(out, "[%s] ", categories[head.category]); }
+            else { fprintf(out, "[#%" PRIu32 "] ", head.category); }
+        }
+
+        const char* payload = data + at + sizeof(head);
+        size_t payload_len = head.len - sizeof(head);
+        if (head.type == __REC_TEXT)
+        {
+            fwrite(payload, 1, payload_len, out);
+        }
+        else if (head.fmt_id >= formats_cnt || formats[head.fmt_id] == NULL)
+        {
+            fprintf(out, "<unknown format #%" PRIu32 ">\n", head.fmt_id);
+        }
+        else if (!__decode_message(out, formats[head.fmt_id], payload, payload_len))
+        {
+            fprintf(out, "<truncated arguments>\n");
+        }
+    }
+    if (out != NULL && fclose(out) != 0) { ret = LOG_RES_ERROR_FILE; }
+
+    for (size_t i = 0; i < formats_cnt; ++i) { free(formats[i]); }
+    free(formats);
+    munmap((void*)data, size);
+    return ret;
+}
+
+
+log_res_e log_dump_register(const char* _name, log_dump_provider_f _provider, void* _ctx,
+    int _priority, unsigned _timeout_ms)
+{
+    if (_name == NULL || _provider == NULL) { return LOG_RES_ERROR_ARG; }
+
+    pthread_mutex_lock(&__dump_providers_mux);
+    __dump_provider_t* free_slot = NULL;
+    for (size_t i = 0; i < LOG_DUMP_MAX_PROVIDERS; ++i)
+    {
+        __dump_provider_t* slot = &__dump_providers[i];
+        if (slot->provider == NULL)
+        {
+            // Prefer slots not used by provider still running
+            if (free_slot == NULL || atomic_load(&free_slot->running) > atomic_load(&slot->running))
+            {
+                free_slot = slot;
+            }
+        }
+        else if (strncmp(slot->name, _name, LOG_DUMP_NAME_SIZE - 1) == 0)
+        {
+            pthread_mutex_unlock(&__dump_providers_mux);
+            return LOG_RES_ERROR_DUP;
+        }
+    }
+    if (free_slot == NULL)
+    {
+        pthread_mutex_unlock(&__dump_providers_mux);
+        return LOG_RES_ERROR_ARG;
+    }
+
+    snprintf(free_slot->name, sizeof(free_slot->name), "%s", _name);
+    free_slot->provider = _provider;
+    free_slot->ctx = _ctx;
+    free_slot->priority = _priority;
+    free_slot->timeout_ms = _timeout_ms ? _timeout_ms : LOG_DUMP_DEFAULT_TIMEOUT_MS;
+    pthread_mutex_unlock(&__dump_providers_mux);
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_dump_unregister(const char* _name)
+{
+    if (_name == NULL) { return LOG_RES_ERROR_ARG; }
+
+    pthread_mutex_lock(&__dump_providers_mux);
+    for (size_t i = 0; i < LOG_DUMP_MAX_PROVIDERS; ++i)
+    {
+        __dump_provider_t* slot = &__dump_providers[i];
+        if (slot->provider != NULL && strncmp(slot->name, _name, LOG_DUMP_NAME_SIZE - 1) == 0)
+        {
+            slot->provider = NULL;
+            pthread_mutex_unlock(&__dump_providers_mux);
+            return LOG_RES_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&__dump_providers_mux);
+    return LOG_RES_ERROR_ARG;
+}
+
+
+log_res_e log_dump_write(log_dump_writer_t* _writer, const void* _data, size_t _len)
+{
+    if (_writer->truncated) { return LOG_RES_ERROR_OTHER; }
+    if (_writer->len + _len > LOG_DUMP_PROVIDER_MAX)
+    {
+        _len = LOG_DUMP_PROVIDER_MAX - _writer->len;
+        _writer->truncated = true;
+    }
+    if (_writer->len + _len > _writer->cap)
+    {
+        size_t cap = _writer->cap ? _writer->cap : 4096;
+        while (cap < _writer->len + _len) { cap *= 2; }
+        char* data = (char*)realloc(_writer->data, cap);
+        if (data == NULL)
+        {
+            _writer->truncated = true;
+            return LOG_RES_ERROR_OTHER;
+        }
+        _writer->data = data;
+        _writer->cap = cap;
+    }
+    memcpy(_writer->data + _writer->len, _data, _len);
+    _writer->len += _len;
+    return _writer->truncated ? LOG_RES_ERROR_OTHER : LOG_RES_SUCCESS;
+}
+
+
+log_res_e log_dump_printf(log_dump_writer_t* _writer, const char* _format, ...)
+{
+    char line[1024];
+    va_list args;
+    va_start(args, _format);
+    int len = vsnprintf(line, sizeof(line), _format, args);
+    va_end(args);
+    if (len < 0) { return LOG_RES_ERROR_OTHER; }
+    if ((size_t)len < sizeof(line)) { return log_dump_write(_writer, line, (size_t)len); }
+
+    // Does not fit on stack
+    char* heap_line = (char*)malloc((size_t)len + 1);
+    if (heap_line == NULL) { return LOG_RES_ERROR_OTHER; }
+    va_start(args, _format);
+    vsnprintf(heap_line, (size_t)len + 1, _format, args);
+    va_end(args);
+    log_res_e ret = log_dump_write(_writer, heap_line, (size_t)len);
+    free(heap_line);
+    return ret;
+}
+
+
+//============================================================================//
+
+
+char* __create_file_name(const char* _name, const char* _extension, unsigned _seq)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    const size_t path_max_len =
+        __path_len + 1 // "${_path }/"
+        + 3 + sizeof(intmax_t) * 8 + 1 // "pid${ PID }_"
+        + (_name != NULL ? strlen(_name) + 1 : 0) // "${_name}_"
+        + 20 + 1 + strlen(_extension) // "${YYYY-MM-DD-HH.mm.ss}.${extension}"
+        + 1 + sizeof(unsigned) * 8 // "_${seq}"
+        + 1 // null-string-terminator
+        ;
+
+    char* path = (char*)calloc(path_max_len, sizeof(char));
+    if (path == NULL) { return NULL; }
+    __render_file_name(path, _name, _extension, _seq, __cached_tm(now.tv_sec));
+
+    return path;
+}
+
+
+size_t __render_file_name(char* _out, const char* _name, const char* _extension, unsigned _seq,
+    const struct tm* _tm)
+{
+    size_t len = __path_len;
+    memcpy(_out, __path, len);
+    memcpy(_out + len, "/pid", 4);
+    len += 4;
+    len += __put_uint(_out + len, (unsigned long long)getpid());
+    _out[len++] = '_';
+    if (_name != NULL)
+    {
+        size_t name_len = strlen(_name);
+        memcpy(_out + len, _name, name_len);
+        len += name_len;
+        _out[len++] = '_';
+    }
+    __put_tm(_out + len, _tm, '-', '.');
+    len += 19;
+    // Sequence number sorts after name without it
+    if (_seq != 0)
+    {
+        _out[len++] = '_';
+        __put_digits(_out + len, _seq, 3);
+        len += 3;
+    }
+    _out[len++] = '.';
+    size_t extension_len = strlen(_extension);
+    if (extension_len > 8) { extension_len = 8; }
+    memcpy(_out + len, _extension, extension_len);
+    len += extension_len;
+    _out[len] = '\0';
+    return len;
+}
+
+
+int __open_log_file(size_t* _written)
+{
+    // Files rotated within same second are numbered on, so that names are never reused
+    // (even after rotated file was compressed or removed) and sort chronologically
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    unsigned seq = now.tv_sec == __log_name_sec ? __log_name_seq + 1 : 0;
+    int fd = -1;
+    for (; fd < 0 && seq < LOG_MAX_NAME_SEQ; ++seq)
+    {
+        char* path = __create_file_name(NULL, "LOG", seq);
+        fd = open(path, O_CREAT | O_EXCL | O_RDWR | O_APPEND,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_ISGID);
+        __errno = errno;
+        if (fd >= 0) { snprintf(__log_name, sizeof(__log_name), "%s", path); }
+        free(path);
+        if (fd < 0 && __errno != EEXIST)
+        {
+            errno = __errno;
+            return -1;
+        }
+    }
+    if (fd < 0) { return -1; }
+    __log_name_sec = now.tv_sec;
+    __log_name_seq = seq - 1;
+
+    // Binary LOG file starts with header describing it, and definitions known so far
+    *_written = 0;
+    if (__format == LOG_FORMAT_BINARY)
+    {
+        __file_head_t file_head = {
+            .version = LOG_BINARY_VERSION,
+            .timestamp = (uint32_t)__ts_mode,
+        };
+        memcpy(file_head.magic, LOG_BINARY_MAGIC, sizeof(file_head.magic));
+        if (write(fd, &file_head, sizeof(file_head)) != sizeof(file_head))
+        {
+            __errno = errno;
+            close(fd);
+            errno = __errno;
+            return -1;
+        }
+        *_written = sizeof(file_head) + __category_write_all(fd) + __fmt_write_all(fd);
+    }
+    return fd;
+}
+ 
+
+const struct tm* __cached_tm(time_t _sec)
+{
+    if (__tls_ts.sec != _sec)
+    {
+        localtime_r(&_sec, &__tls_ts.tm);
+        __put_tm(__tls_ts.text, &__tls_ts.tm, '|', ':');
+        __tls_ts.text[19] = '\0';
+        __tls_ts.sec = _sec;
+    }
+    return &__tls_ts.tm;
+}
+
+
+void __read_clock(struct timespec* _now)
+{
+    switch (__ts_mode)
+    {
+    case LOG_TS_MONOTONIC:
+        clock_gettime(CLOCK_MONOTONIC, _now);
+        break;
+    case LOG_TS_USEC:
+        clock_gettime(CLOCK_REALTIME, _now);
+        break;
+    default:
+        clock_gettime(CLOCK_REALTIME_COARSE, _now);
+        break;
+    }
+}
+
+
+size_t __format_timestamp(char* _out)
+{
+    struct timespec now;
+    __read_clock(&now);
+    return __render_timestamp(_out, &now, __ts_mode);
+}
+
+
+size_t __render_timestamp(char* _out, const struct timespec* _ts, log_ts_e _mode)
+{
+    if (_mode == LOG_TS_MONOTONIC)
+    {
+        size_t len = __put_uint(_out, (unsigned long long)_ts->tv_sec);
+        _out[len] = '.';
+        __put_digits(_out + len + 1, (unsigned long)(_ts->tv_nsec / 1000), 6);
+        return len + 7;
+    }
+
+    __cached_tm(_ts->tv_sec);
+    memcpy(_out, __tls_ts.text, 19);
+    switch (_mode)
+    {
+    case LOG_TS_MSEC:
+        _out[19] = '.';
+        __put_digits(_out + 20, (unsigned long)(_ts->tv_nsec / 1000000), 3);
+        return 23;
+    case LOG_TS_USEC:
+        _out[19] = '.';
+        __put_digits(_out + 20, (unsigned long)(_ts->tv_nsec / 1000), 6);
+        return 26;
+    default:
+        return 19;
+    }
+}
+
+
+void __put_digits(char* _out, unsigned long _value, int _width)
+{
+    for (int i = _width - 1; i >= 0; --i)
+    {
+        _out[i] = (char)('0' + _value % 10);
+        _value /= 10;
+    }
+}
+
+
+size_t __put_uint(char* _out, unsigned long long _value)
+{
+    // Render right-to-left, then reverse
+    char digits[24];
+    size_t len = 0;
+    do
+    {
+        digits[len++] = (char)('0' + _value % 10);
+        _value /= 10;
+    } while (_value > 0);
+    for (size_t i = 0; i < len; ++i) { _out[i] = digits[len - 1 - i]; }
+    return len;
+}
+
+
+size_t __put_str(char* _out, const char* _str)
+{
+    size_t len = strlen(_str);
+    memcpy(_out, _str, len);
+    return len;
+}
+
+
+void __put_tm(char* _out, const struct tm* _tm, char _sep, char _time_sep)
+{
+    __put_digits(_out, (unsigned long)(_tm->tm_year + 1900), 4);
+    _out[4] = '-';
+    __put_digits(_out + 5, (unsigned long)(_tm->tm_mon + 1), 2);
+    _out[7] = '-';
+    __put_digits(_out + 8, (unsigned long)_tm->tm_mday, 2);
+    _out[10] = _sep;
+    __put_digits(_out + 11, (unsigned long)_tm->tm_hour, 2);
+    _out[13] = _time_sep;
+    __put_digits(_out + 14, (unsigned long)_tm->tm_min, 2);
+    _out[16] = _time_sep;
+    __put_digits(_out + 17, (unsigned long)_tm->tm_sec, 2);
+}
+
+
+log_res_e __change_file_lock(int _fd, bool _lock)
+{
+    // Shared LOG file is appended to by many processes
+    if (__shared) { return LOG_RES_SUCCESS; }
+
+    short type;
+    if (_lock == 1) { type = F_WRLCK; }
+    else { type = F_UNLCK; }
+
+    struct flock log_lock = {
+        .l_type = type,
+        .l_whence = SEEK_SET,
+        .l_start = 0,
+        .l_len = 0,
+        .l_pid = getpid()
+    };
+    if (fcntl(_fd, F_SETLK, &log_lock) < 0) { return LOG_RES_ERROR_SYNC; };
+    return LOG_RES_SUCCESS;
+}
+
+
+int __sync_pack(log_sync_e _sync, unsigned _param)
+{
+    switch (_sync)
+    {
+    case LOG_SYNC_MESSAGE:
+    case LOG_SYNC_DATA:
+    case LOG_SYNC_NONE:
+        _param = 0;
+        break;
+    case LOG_SYNC_COUNT:
+        if (_param == 0) { _param = LOG_DEFAULT_SYNC_COUNT; }
+        break;
+    case LOG_SYNC_INTERVAL:
+        if (_param == 0) { _param = LOG_DEFAULT_SYNC_INTERVAL_MS; }
+        break;
+    default:
+        return -1;
+    }
+    if (_param > LOG_SYNC_PARAM_MAX) { return -1; }
+    return (int)(_param << LOG_SYNC_POLICY_BITS) | (int)_sync;
+}
+
+
+void __sync_after(size_t _messages)
+{
+    __sync_file(__log_fd, __control->sync, &__sync_pending, &__sync_last, _messages);
+}
+
+
+void __sync_file(int _fd, int _cfg, size_t* _pending, struct timespec* _last, size_t _messages)
+{
+    bool data_only;
+    if (!__sync_due(_cfg, _pending, _last, _messages, &data_only)) { return; }
+    if (data_only) { fdatasync(_fd); }
+    else { fsync(_fd); }
+    __stats_record(&__stats_local()->sync, __stats_lap(_last));
+}
+
+
+bool __sync_due(int _cfg, size_t* _pending, struct timespec* _last, size_t _messages,
+    bool* _data_only)
+{
+    unsigned param = (unsigned)_cfg >> LOG_SYNC_POLICY_BITS;
+    *_pending += _messages;
+    *_data_only = false;
+    if (*_pending == 0) { return false; }
+
+    bool sync = true;
+    switch ((log_sync_e)(_cfg & ((1 << LOG_SYNC_POLICY_BITS) - 1)))
+    {
+    case LOG_SYNC_MESSAGE:
+        break;
+    case LOG_SYNC_DATA:
+        *_data_only = true;
+        break;
+    case LOG_SYNC_COUNT:
+        if (*_pending < param) { return false; }
+        break;
+    case LOG_SYNC_INTERVAL:
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long elapsed_ms = (now.tv_sec - _last->tv_sec) * 1000LL
+            + (now.tv_nsec - _last->tv_nsec) / 1000000L;
+        if (elapsed_ms < (long long)param) { return false; }
+        break;
+    }
+    case LOG_SYNC_NONE:
+    default:
+        sync = false;
+        break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, _last);
+    *_pending = 0;
+    return sync;
+}
+
+
+log_res_e __dispatch_signal(pid_t _pid, int _signal, int _value)
+{
+    union sigval value = { .sival_int = _value };
+    if (sigqueue(_pid, _signal, value) != 0) { return LOG_RES_ERROR_SYNC; }
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e __register_signal(int _signal, void (*_action) (int, siginfo_t*, void*))
+{
+    sigset_t all;
+    if (_action != NULL)
+    {
+        sigfillset(&all);
+
+        struct sigaction action_config = {
+            .sa_sigaction = _action,
+            .sa_mask = all,
+            .sa_flags = SA_SIGINFO,
+        };
+        if (sigaction(_signal, &action_config, NULL) != 0) { return LOG_RES_ERROR_SYNC; }
+    }
+    else
+    {
+        sigemptyset(&all);
+
+        struct sigaction action_config = {
+            .sa_handler = SIG_DFL,
+            .sa_mask = all,
+            .sa_flags = 0,
+        };
+        if (sigaction(_signal, &action_config, NULL) != 0) { return LOG_RES_ERROR_SYNC; }
+    }
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e __log_vprintf(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args)
+{
+    if (LOG_LVL_MIN > _lvl || _lvl > LOG_LVL_MAX) { return LOG_RES_ERROR_OTHER; }
+    if (__log_enabled[_cat] == 0 || !__writer_enter())
+    {
+        return __stats_result(LOG_RES_OFF, 0);
+    }
+
+    log_res_e ret = __log_vsubmit(_log, _cat, _lvl, _format, _args);
+    __writer_leave();
+    return ret;
+}
+
+
+log_res_e __log_vsubmit(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args)
+{
+    // Call site over its rate is rejected before message is formatted - count of messages
+    // suppressed before is reported before record is assembled in `__tls_record`
+    bool enabled = __log_enabled[_cat] > _lvl;
+    bool pass = enabled && (__rate_interval_ns == 0 || __rate_take(_log, _cat, _lvl, _format));
+
+    // Text record captured by flight recorder is formatted once - it is passed on to writer,
+    // unless message does not go to LOG file, or goes to binary one
+    size_t len = 0;
+    char* record = NULL;
+    if (__flight_size != 0)
+    {
+        va_list args;
+        va_copy(args, _args);
+        record = __format_record(_cat, _lvl, _format, args, &len);
+        va_end(args);
+        if (record != NULL) { __flight_put(record, len); }
+        if (record != NULL && (!pass || (__format == LOG_FORMAT_BINARY && _log == &__log_default)))
+        {
+            if (record != __tls_record) { free(record); }
+            record = NULL;
+        }
+        // Error orders DUMP of context that led to it, while it is still in rings
+        unsigned long long now = __rate_now();
+        unsigned long long ordered = atomic_load_explicit(&__flight_ordered, memory_order_relaxed);
+        if (_lvl == LOG_LVL_MIN && !__tls_library && now - ordered >= LOG_FLIGHT_INTERVAL_NS
+            && atomic_compare_exchange_strong(&__flight_ordered, &ordered, now))
+        {
+            __dump_cmd_t cmd = {
+                .lvl = LOG_DUMP_LVL_NORMAL,
+                .sections = LOG_DUMP_SECTION_FLIGHT,
+                .pid = getpid(),
+                .uid = getuid(),
+            };
+            __dump_order(LOG_DUMP_LVL_NORMAL * 8 + LOG_DUMP_SECTION_FLIGHT, cmd);
+        }
+    }
+    if (!enabled) { return __stats_result(LOG_RES_IGNORED, 0); }
+    if (!pass) { return __stats_result(LOG_RES_SUPPRESSED, 0); }
+
+    __rate_state_t* rate = NULL;
+    if (!__collapse || (__format == LOG_FORMAT_BINARY && _log == &__log_default)
+        || (rate = __rate_local()) == NULL)
+    {
+        if (record != NULL) { return __log_commit(_log, record, len); }
+        return __log_emit(_log, _cat, _lvl, _format, _args);
+    }
+
+    // Count of run may be claimed by other thread once run expires - it is never reset here
+    __repeat_t* run = &rate->repeat;
+    if (record == NULL)
+    {
+        // Run of other call site ends - reported before record is assembled in `__tls_record`
+        if (atomic_load_explicit(&run->repeated, memory_order_relaxed) != 0
+            && atomic_load_explicit(&run->format, memory_order_relaxed) != _format)
+        {
+            __repeat_report(run);
+        }
+        record = __format_record(_cat, _lvl, _format, _args, &len);
+        if (record == NULL) { return __stats_result(LOG_RES_ERROR_OTHER, 0); }
+    }
+    size_t body_len;
+    uint64_t hash = __record_hash(_cat, record, len, &body_len);
+    if (__repeat_match(run, _log, _cat, _lvl, _format, hash, body_len))
+    {
+        if (record != __tls_record) { free(record); }
+        return __stats_result(LOG_RES_SUPPRESSED, 0);
+    }
+    if (atomic_load_explicit(&run->repeated, memory_order_relaxed) != 0)
+    {
+        // Report is assembled in `__tls_record` too - record is moved aside
+        if (record == __tls_record)
+        {
+            record = (char*)malloc(len);
+            if (record == NULL) { return __stats_result(LOG_RES_ERROR_OTHER, 0); }
+            memcpy(record, __tls_record, len);
+        }
+        __repeat_report(run);
+    }
+    run->hash = hash;
+    run->len = body_len;
+    atomic_store_explicit(&run->log, _log, memory_order_relaxed);
+    atomic_store_explicit(&run->cat, _cat, memory_order_relaxed);
+    atomic_store_explicit(&run->lvl, _lvl, memory_order_relaxed);
+    atomic_store_explicit(&run->since, __rate_now(), memory_order_relaxed);
+    atomic_store_explicit(&run->format, _format, memory_order_relaxed);
+
+    return __log_commit(_log, record, len);
+}
+
+
+log_res_e __log_emit(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format,
+    va_list _args)
+{
+    // LOG files of instances are always text
+    size_t len;
+    char* record;
+    if (__format == LOG_FORMAT_BINARY && _log == &__log_default)
+    {
+        record = __encode_record(_cat, _lvl, _format, _args, &len);
+    }
+    else { record = __format_record(_cat, _lvl, _format, _args, &len); }
+    if (record == NULL) { return __stats_result(LOG_RES_ERROR_OTHER, 0); }
+
+    return __log_commit(_log, record, len);
+}
+
+
+log_res_e __log_commit(log_t* _log, char* _record, size_t _len)
+{
+    log_res_e ret = __stats_result(_log == &__log_default
+        ? __commit_record(_record, _len)
+        : __instance_write(_log, _record, _len), _len);
+    if (_record != __tls_record) { free(_record); }
+
+    return ret;
+}
+
+
+void __log_notice(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format, ...)
+{
+    if (__log_enabled[_cat] <= _lvl) { return; }
+
+    va_list args;
+    va_start(args, _format);
+    __log_emit(_log, _cat, _lvl, _format, args);
+    va_end(args);
+}
+
+
+bool __log_pin(log_t* _log)
+{
+    if (_log == &__log_default) { return true; }
+
+    // List lock is held only while instance is looked up - never while notice is written
+    pthread_mutex_lock(&__instances_mux);
+    log_t* log = __instances;
+    while (log != NULL && log != _log) { log = log->next; }
+    if (log != NULL) { atomic_fetch_add(&log->pins, 1); }
+    pthread_mutex_unlock(&__instances_mux);
+    return log != NULL;
+}
+
+
+void __log_unpin(log_t* _log)
+{
+    if (_log != &__log_default) { atomic_fetch_sub_explicit(&_log->pins, 1, memory_order_release); }
+}
+
+
+__rate_state_t* __rate_local(void)
+{
+    if (__tls_rate != NULL) { return __tls_rate; }
+
+    // Reuse block of exited thread - its counts were reported when it exited
+    __rate_state_t* rate = atomic_load_explicit(&__rate_list, memory_order_acquire);
+    for (; rate != NULL; rate = rate->next)
+    {
+        bool used = false;
+        if (atomic_compare_exchange_strong(&rate->used, &used, true)) { break; }
+    }
+    if (rate != NULL)
+    {
+        // Call sites of previous owner are not continued - its counts were claimed
+        atomic_store_explicit(&rate->repeat.format, NULL, memory_order_relaxed);
+        for (size_t i = 0; i < sizeof(rate->slots) / sizeof(rate->slots[0]); ++i)
+        {
+            atomic_store_explicit(&rate->slots[i].format, NULL, memory_order_relaxed);
+        }
+    }
+    else if ((rate = (__rate_state_t*)calloc(1, sizeof(__rate_state_t))) != NULL)
+    {
+        atomic_init(&rate->used, true);
+        rate->next = atomic_load_explicit(&__rate_list, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&__rate_list, &rate->next, rate,
+            memory_order_release, memory_order_relaxed))
+        {
+        }
+    }
+    __tls_rate = rate;
+    return rate;
+}
+
+
+bool __rate_take(log_t* _log, log_category_t _cat, log_lvl_e _lvl, const char* _format)
+{
+    __rate_state_t* rate = __rate_local();
+    if (rate == NULL) { return true; }
+
+    // Fibonacci hashing of address - call sites pass distinct literals
+    __rate_slot_t* slot = &rate->slots[((uint64_t)(uintptr_t)_format * 0x9E3779B97F4A7C15ULL)
+        >> (64 - LOG_RATE_SLOTS_BITS)];
+    uint64_t now = __rate_now();
+    uint64_t tat = atomic_load_explicit(&slot->tat, memory_order_relaxed);
+    if (atomic_load_explicit(&slot->format, memory_order_relaxed) != _format)
+    {
+        // Slot is taken over by colliding call site, with full bucket
+        __rate_report(slot);
+        atomic_store_explicit(&slot->format, _format, memory_order_relaxed);
+        tat = now;
+    }
+    if (tat > now + __rate_burst_ns)
+    {
+        // Target is published before count, which other threads claim first
+        atomic_store_explicit(&slot->log, _log, memory_order_relaxed);
+        atomic_store_explicit(&slot->cat, _cat, memory_order_relaxed);
+        atomic_store_explicit(&slot->lvl, _lvl, memory_order_relaxed);
+        atomic_fetch_add_explicit(&slot->suppressed, 1, memory_order_release);
+        return false;
+    }
+    // Window closes with this message - count of it is reported after it is published
+    tat = (tat > now ? tat : now) + __rate_interval_ns;
+    atomic_store_explicit(&slot->tat, tat, memory_order_release);
+    if (atomic_load_explicit(&slot->suppressed, memory_order_relaxed) != 0) { __rate_report(slot); }
+    return true;
+}
+
+
+void __rate_report(__rate_slot_t* _slot)
+{
+    // Target is pinned before count is claimed - count of closed one is left in slot
+    log_t* log = atomic_load_explicit(&_slot->log, memory_order_relaxed);
+    if (!__log_pin(log)) { return; }
+    // Count is claimed by single thread - owning one, or one reporting closed windows
+    unsigned suppressed = atomic_exchange_explicit(&_slot->suppressed, 0, memory_order_acquire);
+    if (suppressed != 0)
+    {
+        __log_notice(log, atomic_load_explicit(&_slot->cat, memory_order_relaxed),
+            atomic_load_explicit(&_slot->lvl, memory_order_relaxed),
+            "Suppressed %u messages by rate limit: %s", suppressed,
+            atomic_load_explicit(&_slot->format, memory_order_relaxed));
+    }
+    __log_unpin(log);
+}
+
+
+uint64_t __record_hash(log_category_t _cat, const char* _record, size_t _len, size_t* _body_len)
+{
+    // Header ends with "] " after timestamp (which has no ']'), and tag of category
+    const char* end = (const char*)memchr(_record + 7, ']', _len - 7);
+    const char* body = end != NULL ? end + 2 : _record;
+    if (end != NULL && _cat != LOG_CATEGORY_DEFAULT) { body += strlen(__category_names[_cat]) + 3; }
+    if (body > _record + _len) { body = _record + _len; }
+
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char* c = body; c < _record + _len; ++c)
+    {
+        hash = (hash ^ (unsigned char)*c) * 0x100000001B3ULL;
+    }
+    *_body_len = (size_t)(_record + _len - body);
+    return hash;
+}
+
+
+bool __repeat_match(__repeat_t* _run, log_t* _log, log_category_t _cat, log_lvl_e _lvl,
+    const char* _format, uint64_t _hash, size_t _len)
+{
+    __repeat_t* run = _run;
+    if (atomic_load_explicit(&run->format, memory_order_relaxed) != _format
+        || atomic_load_explicit(&run->log, memory_order_relaxed) != _log
+        || atomic_load_explicit(&run->cat, memory_order_relaxed) != _cat
+        || atomic_load_explicit(&run->lvl, memory_order_relaxed) != _lvl
+        || run->hash != _hash || run->len != _len)
+    {
+        return false;
+    }
+    // Long run is reported, and starts again with this message
+    if (__rate_now() - atomic_load_explicit(&run->since, memory_order_relaxed) >= LOG_REPEAT_WINDOW_NS)
+    {
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&run->repeated, 1, memory_order_release);
+    return true;
+}
+
+
+void __repeat_report(__repeat_t* _run)
+{
+    // Target is pinned before count is claimed - count of closed one is left in run
+    log_t* log = atomic_load_explicit(&_run->log, memory_order_relaxed);
+    if (!__log_pin(log)) { return; }
+    // Count is claimed by single thread - owning one, or one reporting expired runs
+    unsigned repeated = atomic_exchange_explicit(&_run->repeated, 0, memory_order_acquire);
+    if (repeated != 0)
+    {
+        __log_notice(log, atomic_load_explicit(&_run->cat, memory_order_relaxed),
+            atomic_load_explicit(&_run->lvl, memory_order_relaxed),
+            "Last message repeated %u times", repeated);
+    }
+    __log_unpin(log);
+}
+
+
+void __rate_state_flush(__rate_state_t* _rate, log_t* _log, bool _expired)
+{
+    uint64_t now = __rate_now();
+    __repeat_t* run = &_rate->repeat;
+    if ((_log == NULL || atomic_load_explicit(&run->log, memory_order_relaxed) == _log)
+        && (!_expired || (atomic_load_explicit(&run->repeated, memory_order_relaxed) != 0
+            && now - atomic_load_explicit(&run->since, memory_order_acquire) >= LOG_REPEAT_WINDOW_NS)))
+    {
+        __repeat_report(run);
+        // Run ends, so that message printed after flush is not collapsed
+        atomic_store_explicit(&run->format, NULL, memory_order_relaxed);
+    }
+    for (size_t i = 0; i < sizeof(_rate->slots) / sizeof(_rate->slots[0]); ++i)
+    {
+        // Window of call site closes once its next message would pass
+        __rate_slot_t* slot = &_rate->slots[i];
+        if (atomic_load_explicit(&slot->suppressed, memory_order_relaxed) != 0
+            && (_log == NULL || atomic_load_explicit(&slot->log, memory_order_relaxed) == _log)
+            && (!_expired
+                || atomic_load_explicit(&slot->tat, memory_order_acquire) <= now + __rate_burst_ns))
+        {
+            __rate_report(slot);
+        }
+    }
+}
+
+
+void __rate_flush(log_t* _log, bool _expired)
+{
+    for (__rate_state_t* rate = atomic_load_explicit(&__rate_list, memory_order_acquire);
+        rate != NULL; rate = rate->next)
+    {
+        // Blocks of exited threads are flushed too - thread exiting while `log_deinit` runs
+        // leaves its counts to it
+        __rate_state_flush(rate, _log, _expired);
+    }
+}
+
+
+__flight_t* __flight_local(void)
+{
+    __flight_t* flight = __tls_flight;
+    if (flight != NULL && flight->size == __flight_size) { return flight; }
+    // Ring of previous initialization is left for another thread
+    if (flight != NULL) { atomic_store_explicit(&flight->used, false, memory_order_release); }
+    __tls_flight = NULL;
+
+    for (flight = atomic_load_explicit(&__flight_list, memory_order_acquire);
+        flight != NULL;
+        flight = flight->next)
+    {
+        bool expected = false;
+        if (flight->size == __flight_size
+            && atomic_compare_exchange_strong(&flight->used, &expected, true))
+        {
+            break;
+        }
+    }
+    if (flight == NULL)
+    {
+        flight = (__flight_t*)malloc(sizeof(__flight_t) + __flight_size);
+        if (flight == NULL) { return NULL; }
+        flight->size = __flight_size;
+        atomic_init(&flight->used, true);
+        flight->next = atomic_load_explicit(&__flight_list, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&__flight_list, &flight->next, flight,
+            memory_order_release, memory_order_relaxed));
+    }
+    if (__tls_tid == 0) { __tls_tid = (pid_t)syscall(__NR_gettid); }
+    atomic_store(&flight->tid, __tls_tid);
+    atomic_store_explicit(&flight->head, 0, memory_order_release);
+
+    // Ring is released by `__stats_exit`
+    __stats_local();
+    __tls_flight = flight;
+    return flight;
+}
+
+
+void __flight_put(const char* _record, size_t _len)
+{
+    __flight_t* flight = __flight_local();
+    // Record longer than ring would only overwrite it with its own tail
+    if (flight == NULL || _len > flight->size) { return; }
+
+    unsigned long long head = atomic_load_explicit(&flight->head, memory_order_relaxed);
+    size_t at = head & (flight->size - 1);
+    size_t first = flight->size - at < _len ? flight->size - at : _len;
+    memcpy(flight->data + at, _record, first);
+    memcpy(flight->data, _record + first, _len - first);
+    atomic_store_explicit(&flight->head, head + _len, memory_order_release);
+}
+
+
+unsigned long long __flight_start(const __flight_t* _flight, unsigned long long _from,
+    unsigned long long _head)
+{
+    if (_from == 0) { return 0; }
+    for (unsigned long long pos = _from; pos < _head; ++pos)
+    {
+        if (_flight->data[pos & (_flight->size - 1)] == '\n') { return pos + 1; }
+    }
+    return _head;
+}
+
+
+void __flight_render(__dump_writer_t* _writer)
+{
+    __dump_printf(_writer, "\n# Flight recorder - latest messages of every thread, oldest first\n");
+    for (__flight_t* flight = atomic_load_explicit(&__flight_list, memory_order_acquire);
+        flight != NULL;
+        flight = flight->next)
+    {
+        unsigned long long head = atomic_load_explicit(&flight->head, memory_order_acquire);
+        if (head == 0) { continue; }
+        char* copy = (char*)malloc(flight->size);
+        if (copy == NULL)
+        {
+            __dump_printf(_writer, "\n## Thread %d - not enough memory\n", atomic_load(&flight->tid));
+            continue;
+        }
+
+        // Owner keeps capturing - bytes it overwrote during copying are skipped
+        unsigned long long from = head > flight->size ? head - flight->size : 0;
+        size_t at = from & (flight->size - 1);
+        size_t first = flight->size - at < head - from ? flight->size - at : head - from;
+        memcpy(copy, flight->data + at, first);
+        memcpy(copy + first, flight->data, head - from - first);
+        unsigned long long after = atomic_load_explicit(&flight->head, memory_order_acquire);
+        unsigned long long start = after > flight->size && after - flight->size > from
+            ? after - flight->size : from;
+        if (start >= head) { start = head; }
+        else if (start != 0)
+        {
+            char* newline = (char*)memchr(copy + (start - from), '\n', head - start);
+            start = newline != NULL ? from + (unsigned long long)(newline - copy) + 1 : head;
+        }
+
+        __dump_printf(_writer, "\n## Thread %d%s - %llu B captured, %llu B shown\n",
+            atomic_load(&flight->tid), atomic_load(&flight->used) ? "" : " (exited)",
+            head, head - start);
+        __dump_put(_writer, copy + (start - from), head - start);
+        free(copy);
+    }
+}
+
+
+void __flight_crash(int _fd)
+{
+    struct iovec iov = { .iov_base = "\n# Flight recorder\n", .iov_len = 19 };
+    __writev_all(_fd, &iov, 1);
+    for (__flight_t* flight = atomic_load_explicit(&__flight_list, memory_order_acquire);
+        flight != NULL;
+        flight = flight->next)
+    {
+        unsigned long long head = atomic_load_explicit(&flight->head, memory_order_acquire);
+        if (head == 0) { continue; }
+
+        // `## Thread TID`
+        char line[64];
+        size_t len = __put_str(line, "\n## Thread ");
+        len += __put_uint(line + len, (unsigned long long)atomic_load(&flight->tid));
+        len += __put_str(line + len, atomic_load(&flight->used) ? "\n" : " (exited)\n");
+        unsigned long long start = __flight_start(flight,
+            head > flight->size ? head - flight->size : 0, head);
+        size_t at = start & (flight->size - 1);
+        size_t first = flight->size - at < head - start ? flight->size - at : head - start;
+        struct iovec ring[3] = {
+            { .iov_base = line, .iov_len = len },
+            { .iov_base = flight->data + at, .iov_len = first },
+            { .iov_base = flight->data, .iov_len = head - start - first },
+        };
+        __writev_all(_fd, ring, 3);
+    }
+}
+
+
+uint64_t __rate_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+void __log_set_level(log_category_t _cat, log_lvl_e _lvl)
+{
+    if (_cat < LOG_MAX_CATEGORIES)
+    {
+        __log_enabled[_cat] = _lvl + 1;
+        return;
+    }
+    for (size_t i = 0; i < LOG_MAX_CATEGORIES; ++i) { __log_enabled[i] = _lvl + 1; }
+}
+
+
+void __category_define(log_category_t _cat)
+{
+    char record[sizeof(__rec_head_t) + LOG_CATEGORY_NAME_SIZE];
+    size_t name_len = strlen(__category_names[_cat]);
+    __rec_head_t head = {
+        .len = (uint32_t)(sizeof(head) + name_len),
+        .type = __REC_CAT,
+        .fmt_id = _cat,
+    };
+    memcpy(record, &head, sizeof(head));
+    memcpy(record + sizeof(head), __category_names[_cat], name_len);
+    __commit_record(record, head.len);
+}
+
+
+size_t __category_write_all(int _fd)
+{
+    size_t written = 0;
+    unsigned count = atomic_load(&__category_count);
+    for (unsigned i = 1; i < count; ++i)
+    {
+        size_t name_len = strlen(__category_names[i]);
+        __rec_head_t head = {
+            .len = (uint32_t)(sizeof(head) + name_len),
+            .type = __REC_CAT,
+            .fmt_id = i,
+        };
+        struct iovec iov[2] = {
+            { .iov_base = &head, .iov_len = sizeof(head) },
+            { .iov_base = __category_names[i], .iov_len = name_len },
+        };
+        if (__writev_all(_fd, iov, 2) == LOG_RES_SUCCESS) { written += head.len; }
+    }
+    return written;
+}
+
+
+bool __kv_reserve(__kv_buf_t* _buf, size_t _len)
+{
+    if (_buf->overflow) { return false; }
+    if (_buf->len + _len <= _buf->cap) { return true; }
+    // Closing part of record must always fit
+    if (_buf->len + _len + LOG_KV_TRAILER > __max_record)
+    {
+        _buf->overflow = true;
+        return false;
+    }
+
+    size_t cap = _buf->cap * 2;
+    while (cap < _buf->len + _len + LOG_KV_TRAILER) { cap *= 2; }
+    if (cap > __max_record) { cap = __max_record; }
+    char* data = _buf->data == __tls_record ? (char*)malloc(cap) : (char*)realloc(_buf->data, cap);
+    if (data == NULL)
+    {
+        _buf->overflow = true;
+        return false;
+    }
+    if (_buf->data == __tls_record) { memcpy(data, __tls_record, _buf->len); }
+    _buf->data = data;
+    _buf->cap = cap;
+    return true;
+}
+
+
+void __kv_put(__kv_buf_t* _buf, const char* _data, size_t _len)
+{
+    if (!__kv_reserve(_buf, _len)) { return; }
+    memcpy(_buf->data + _buf->len, _data, _len);
+    _buf->len += _len;
+}
+
+
+void __kv_put_uint(__kv_buf_t* _buf, unsigned long long _value, bool _negative)
+{
+    // Render digits right-to-left
+    char digits[24];
+    size_t at = sizeof(digits);
+    do
+    {
+        digits[--at] = (char)('0' + _value % 10);
+        _value /= 10;
+    } while (_value > 0);
+    if (_negative) { digits[--at] = '-'; }
+    __kv_put(_buf, digits + at, sizeof(digits) - at);
+}
+
+
+void __kv_put_str(__kv_buf_t* _buf, const char* _value)
+{
+    static const char hex[] = "0123456789abcdef";
+    bool json = __kv_format == LOG_KV_JSON;
+    if (_value == NULL)
+    {
+        __kv_put(_buf, "null", json ? 4 : 0);
+        return;
+    }
+
+    // logfmt values are quoted only if they contain spaces, quotes or `=`
+    size_t len = strlen(_value);
+    bool quote = json || len == 0 || strpbrk(_value, " =\"\\") != NULL;
+    for (size_t i = 0; !quote && i < len; ++i) { quote = (unsigned char)_value[i] < 0x20; }
+
+    // Worst case - every character escaped as \u00XX
+    if (!__kv_reserve(_buf, len * 6 + 2)) { return; }
+    char* out = _buf->data + _buf->len;
+    if (quote) { *out++ = '"'; }
+    for (size_t i = 0; i < len; ++i)
+    {
+        unsigned char c = (unsigned char)_value[i];
+        if (c == '"' || c == '\\')
+        {
+            *out++ = '\\';
+            *out++ = (char)c;
+        }
+        else if (c == '\n') { *out++ = '\\'; *out++ = 'n'; }
+        else if (c == '\t') { *out++ = '\\'; *out++ = 't'; }
+        else if (c == '\r') { *out++ = '\\'; *out++ = 'r'; }
+        else if (c < 0x20)
+        {
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[c >> 4];
+            out[5] = hex[c & 0xF];
+            out += 6;
+        }
+        else { *out++ = (char)c; }
+    }
+    if (quote) { *out++ = '"'; }
+    _buf->len = (size_t)(out - _buf->data);
+}
+
+
+void __kv_put_key(__kv_buf_t* _buf, const char* _key)
+{
+    if (__kv_format == LOG_KV_JSON)
+    {
+        __kv_put_str(_buf, _key);
+        __kv_put(_buf, ":", 1);
+    }
+    else
+    {
+        __kv_put(_buf, _key, strlen(_key));
+        __kv_put(_buf, "=", 1);
+    }
+}
+
+
+void __kv_put_value(__kv_buf_t* _buf, const log_field_t* _field)
+{
+    switch (_field->type)
+    {
+    case LOG_FIELD_INT:
+    case LOG_FIELD_PID:
+    case LOG_FIELD_TID:
+        __kv_put_uint(_buf, _field->value.i < 0
+            ? 0ULL - (unsigned long long)_field->value.i
+            : (unsigned long long)_field->value.i, _field->value.i < 0);
+        break;
+    case LOG_FIELD_UINT:
+        __kv_put_uint(_buf, _field->value.u, false);
+        break;
+    case LOG_FIELD_DOUBLE:
+    {
+        // JSON has no representation of NaN and infinities
+        if (_field->value.d != _field->value.d
+            || _field->value.d > 1.7976931348623157e308
+            || _field->value.d < -1.7976931348623157e308)
+        {
+            if (__kv_format == LOG_KV_JSON) { __kv_put(_buf, "null", 4); }
+            else { __kv_put(_buf, _field->value.d != _field->value.d ? "NaN" : "Inf", 3); }
+            break;
+        }
+        char number[32];
+        int len = snprintf(number, sizeof(number), "%.17g", _field->value.d);
+        __kv_put(_buf, number, (size_t)len);
+        break;
+    }
+    case LOG_FIELD_STR:
+        __kv_put_str(_buf, _field->value.s);
+        break;
+    case LOG_FIELD_BOOL:
+        if (_field->value.b) { __kv_put(_buf, "true", 4); }
+        else { __kv_put(_buf, "false", 5); }
+        break;
+    default:
+        __kv_put(_buf, "null", 4);
+        break;
+    }
+}
+
+
+char* __format_record(log_category_t _cat, log_lvl_e _lvl, const char* _format, va_list _args,
+    size_t* _len)
+{
+    char* record = __tls_record;
+    memcpy(record, __lvl_tags[_lvl], 7);
+    size_t head_len = 7 + __format_timestamp(record + 7);
+    memcpy(record + head_len, "] ", 2);
+    head_len += 2;
+    // Messages of registered categories are tagged with name of category
+    if (_cat != LOG_CATEGORY_DEFAULT)
+    {
+        size_t name_len = strlen(__category_names[_cat]);
+        record[head_len] = '[';
+        memcpy(record + head_len + 1, __category_names[_cat], name_len);
+        memcpy(record + head_len + 1 + name_len, "] ", 2);
+        head_len += name_len + 3;
+    }
+
+    return __format_body(head_len, _format, _args, _len);
+}
+
+
+char* __format_body(size_t _head_len, const char* _format, va_list _args, size_t* _len)
+{
+    char* record = __tls_record;
+    size_t cap = sizeof(__tls_record) < __max_record ? sizeof(__tls_record) : __max_record;
+
+    va_list args;
+    va_copy(args, _args);
+    int body_len = vsnprintf(record + _head_len, cap - _head_len, _format, args);
+    va_end(args);
+    if (body_len < 0) { return NULL; }
+
+    // Record length includes newline, which replaces null-string-terminator
+    size_t len = _head_len + (size_t)body_len + 1;
+    if (len > cap && cap < __max_record)
+    {
+        // Oversize message - assemble again in heap, up to maximum record size
+        cap = len < __max_record ? len : __max_record;
+        char* heap_record = (char*)malloc(cap);
+        if (heap_record == NULL) { return NULL; }
+        memcpy(heap_record, record, _head_len);
+        record = heap_record;
+        vsnprintf(record + _head_len, cap - _head_len, _format, _args);
+    }
+    if (len > cap)
+    {
+        len = cap;
+        memcpy(record + len - sizeof(LOG_TRUNCATED_MARKER),
+            LOG_TRUNCATED_MARKER, sizeof(LOG_TRUNCATED_MARKER) - 1);
+    }
+    record[len - 1] = '\n';
+
+    *_len = len;
+    return record;
+}
+
+
+bool __writer_enter(void)
+{
+    // Sequentially consistent pair with `__writer_quiesce` - either section is seen by it,
+    // or closing is seen here
+    atomic_fetch_add(&__writers_inflight, 1);
+    if (atomic_load(&__writers_open)) { return true; }
+    atomic_fetch_sub(&__writers_inflight, 1);
+    return false;
+}
+
+
+void __writer_leave(void)
+{
+    atomic_fetch_sub_explicit(&__writers_inflight, 1, memory_order_release);
+}
+
+
+void __writer_quiesce(void)
+{
+    atomic_store(&__writers_open, false);
+    while (atomic_load(&__writers_inflight) != 0) { sched_yield(); }
+}
+
+
+char* __encode_record(log_category_t _cat, log_lvl_e _lvl, const char* _format, va_list _args,
+    size_t* _len)
+{
+    struct timespec now;
+    __read_clock(&now);
+    __rec_head_t head = {
+        .type = __REC_MSG,
+        .lvl = (uint16_t)_lvl,
+        .category = (uint32_t)_cat,
+        .ts_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec,
+    };
+
+    char* record = __tls_record;
+    size_t cap = sizeof(__tls_record) < __max_record ? sizeof(__tls_record) : __max_record;
+    __fmt_info_t* info = __fmt_lookup(_format);
+    if (info != NULL && info->deferred)
+    {
+        if (!atomic_load_explicit(&info->defined, memory_order_acquire)) { __fmt_define(info); }
+        head.fmt_id = info->id;
+
+        va_list args;
+        va_copy(args, _args);
+        size_t len = sizeof(head) + __encode_args(record + sizeof(head), cap - sizeof(head), info, args);
+        va_end(args);
+        if (len > cap && len <= __max_record)
+        {
+            if ((record = (char*)malloc(len)) == NULL) { return NULL; }
+            __encode_args(record + sizeof(head), len - sizeof(head), info, _args);
+        }
+        if (len <= __max_record)
+        {
+            head.len = (uint32_t)len;
+            memcpy(record, &head, sizeof(head));
+            *_len = len;
+            return record;
+        }
+        // Arguments do not fit in maximum record size - store preformatted and truncated
+    }
+
+    head.type = __REC_TEXT;
+    record = __format_body(sizeof(head), _format, _args, _len);
+    if (record == NULL) { return NULL; }
+    head.len = (uint32_t)*_len;
+    memcpy(record, &head, sizeof(head));
+    return record;
+}
+
+
+void __encode_put(char* _out, size_t _cap, size_t* _len, const void* _data, size_t _size)
+{
+    if (*_len + _size <= _cap) { memcpy(_out + *_len, _data, _size); }
+    *_len += _size;
+}
+
+
+size_t __encode_args(char* _out, size_t _cap, const __fmt_info_t* _info, va_list _args)
+{
+    size_t len = 0;
+    // Value of last `int` argument - precision of following `%.*s`
+    int last_int = -1;
+    for (int i = 0; i < _info->argc; ++i)
+    {
+        const __fmt_spec_t* arg = &_info->args[i];
+        switch (arg->type)
+        {
+        case __ARG_INT:
+        {
+            int value = va_arg(_args, int);
+            last_int = value;
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_LONG:
+        {
+            long value = va_arg(_args, long);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_LLONG:
+        {
+            long long value = va_arg(_args, long long);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_INTMAX:
+        {
+            intmax_t value = va_arg(_args, intmax_t);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_SIZE:
+        {
+            size_t value = va_arg(_args, size_t);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_PTRDIFF:
+        {
+            ptrdiff_t value = va_arg(_args, ptrdiff_t);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_DOUBLE:
+        {
+            double value = va_arg(_args, double);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_LDOUBLE:
+        {
+            long double value = va_arg(_args, long double);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_PTR:
+        {
+            void* value = va_arg(_args, void*);
+            __encode_put(_out, _cap, &len, &value, sizeof(value));
+            break;
+        }
+        case __ARG_STR:
+        {
+            const char* value = va_arg(_args, const char*);
+            if (value == NULL) { value = "(null)"; }
+            int prec = arg->star_prec ? last_int : arg->prec;
+            uint32_t value_len = (uint32_t)(prec >= 0 ? strnlen(value, (size_t)prec) : strlen(value));
+            __encode_put(_out, _cap, &len, &value_len, sizeof(value_len));
+            __encode_put(_out, _cap, &len, value, value_len);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return len;
+}
+
+
+const char* __fmt_parse(const char* _p, __fmt_spec_t* _spec)
+{
+    *_spec = (__fmt_spec_t){ .type = __ARG_BAD, .prec = -1 };
+    ++_p;
+    if (*_p == '%')
+    {
+        _spec->type = __ARG_NONE;
+        return _p + 1;
+    }
+
+    // Flags
+    while (*_p != '\0' && strchr("-+ #0'I", *_p) != NULL) { ++_p; }
+    // Width
+    if (*_p == '*')
+    {
+        _spec->star_width = true;
+        ++_p;
+    }
+    while (*_p >= '0' && *_p <= '9') { ++_p; }
+    // Positional arguments are not supported
+    if (*_p == '$') { return _p + 1; }
+    // Precision
+    if (*_p == '.')
+    {
+        ++_p;
+        if (*_p == '*')
+        {
+            _spec->star_prec = true;
+            ++_p;
+        }
+        else
+        {
+            _spec->prec = 0;
+            while (*_p >= '0' && *_p <= '9') { _spec->prec = _spec->prec * 10 + (*_p++ - '0'); }
+        }
+    }
+    // Length modifier
+    char length = '\0';
+    switch (*_p)
+    {
+    case 'h':
+        length = 'h';
+        if (*++_p == 'h') { ++_p; }
+        break;
+    case 'l':
+        length = 'l';
+        if (*++_p == 'l')
+        {
+            length = 'q';
+            ++_p;
+        }
+        break;
+    case 'q':
+    case 'L':
+    case 'j':
+    case 'z':
+    case 't':
+        length = *_p++;
+        break;
+    default: break;
+    }
+    // Conversion
+    switch (*_p)
+    {
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        switch (length)
+        {
+        case 'l': _spec->type = __ARG_LONG; break;
+        case 'q':
+        case 'L': _spec->type = __ARG_LLONG; break;
+        case 'j': _spec->type = __ARG_INTMAX; break;
+        case 'z': _spec->type = __ARG_SIZE; break;
+        case 't': _spec->type = __ARG_PTRDIFF; break;
+        default: _spec->type = __ARG_INT; break;
+        }
+        break;
+    case 'c':
+        _spec->type = __ARG_INT;
+        break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        _spec->type = length == 'L' ? __ARG_LDOUBLE : __ARG_DOUBLE;
+        break;
+    case 's':
+        _spec->type = length == 'l' ? __ARG_BAD : __ARG_STR;
+        break;
+    case 'p':
+        _spec->type = __ARG_PTR;
+        break;
+    case '\0':
+        return _p;
+    default: break;
+    }
+    return _p + 1;
+}
+
+
+__fmt_info_t* __fmt_lookup(const char* _format)
+{
+    size_t slot = (size_t)(((uintptr_t)_format >> 3) * 2654435761u) % LOG_FMT_TABLE_SIZE;
+    __fmt_info_t* created = NULL;
+    for (size_t probe = 0; probe < LOG_FMT_TABLE_SIZE; ++probe)
+    {
+        _Atomic(__fmt_info_t*)* entry = &__fmt_table[(slot + probe) % LOG_FMT_TABLE_SIZE];
+        __fmt_info_t* info = atomic_load_explicit(entry, memory_order_acquire);
+        if (info == NULL)
+        {
+            if (created == NULL)
+            {
+                // Parse format string once - its arguments are known afterwards
+                if ((created = (__fmt_info_t*)calloc(1, sizeof(__fmt_info_t))) == NULL) { return NULL; }
+                created->format = _format;
+                created->deferred = true;
+                atomic_init(&created->defined, false);
+                for (const char* p = _format; *p != '\0' && created->deferred; )
+                {
+                    if (*p != '%')
+                    {
+                        ++p;
+                        continue;
+                    }
+                    __fmt_spec_t spec;
+                    p = __fmt_parse(p, &spec);
+                    int argc = created->argc + spec.star_width + spec.star_prec
+                        + (spec.type != __ARG_NONE);
+                    if (spec.type == __ARG_BAD || argc > LOG_FMT_MAX_ARGS)
+                    {
+                        created->deferred = false;
+                        break;
+                    }
+                    if (spec.star_width) { created->args[created->argc++].type = __ARG_INT; }
+                    if (spec.star_prec) { created->args[created->argc++].type = __ARG_INT; }
+                    if (spec.type != __ARG_NONE) { created->args[created->argc++] = spec; }
+                }
+            }
+            created->id = atomic_fetch_add_explicit(&__fmt_last_id, 1, memory_order_relaxed) + 1;
+            if (atomic_compare_exchange_strong_explicit(entry, &info, created,
+                memory_order_acq_rel, memory_order_acquire))
+            {
+                return created;
+            }
+            // Slot was taken in meantime - `info` holds entry of other thread
+        }
+        if (info->format == _format)
+        {
+            free(created);
+            return info;
+        }
+    }
+    free(created);
+    return NULL;
+}
+
+
+void __fmt_define(__fmt_info_t* _info)
+{
+    size_t format_len = strlen(_info->format);
+    size_t len = sizeof(__rec_head_t) + format_len;
+    char* record = (char*)malloc(len);
+    if (record == NULL) { return; }
+
+    __rec_head_t head = {
+        .len = (uint32_t)len,
+        .type = __REC_DEF,
+        .fmt_id = _info->id,
+    };
+    memcpy(record, &head, sizeof(head));
+    memcpy(record + sizeof(head), _info->format, format_len);
+    // Definition may be committed twice by racing threads - decoder ignores duplicates
+    if (__commit_record(record, len) == LOG_RES_SUCCESS)
+    {
+        atomic_store_explicit(&_info->defined, true, memory_order_release);
+    }
+    free(record);
+}
+
+
+void __fmt_clear(void)
+{
+    for (size_t i = 0; i < LOG_FMT_TABLE_SIZE; ++i)
+    {
+        free(atomic_exchange_explicit(&__fmt_table[i], NULL, memory_order_acq_rel));
+    }
+}
+
+
+bool __decode_message(FILE* _out, const char* _format, const char* _args, size_t _size)
+{
+    size_t at = 0;
+    const char* p = _format;
+    while (*p != '\0')
+    {
+        if (*p != '%')
+        {
+            const char* next = strchr(p, '%');
+            if (next == NULL) { next = p + strlen(p); }
+            fwrite(p, 1, (size_t)(next - p), _out);
+            p = next;
+            continue;
+        }
+
+        __fmt_spec_t spec;
+        const char* end = __fmt_parse(p, &spec);
+        if (spec.type == __ARG_NONE)
+        {
+            fputc('%', _out);
+            p = end;
+            continue;
+        }
+        int width = 0;
+        int prec = -1;
+        if (spec.star_width && !__decode_take(_args, _size, &at, &width, sizeof(width))) { return false; }
+        if (spec.star_prec && !__decode_take(_args, _size, &at, &prec, sizeof(prec))) { return false; }
+
+        // Rebuild specification with `*` replaced by stored values
+        char conv[64];
+        size_t conv_len = 0;
+        for (const char* c = p; c < end && conv_len < sizeof(conv) - 16; ++c)
+        {
+            if (*c != '*') { conv[conv_len++] = *c; }
+            else if (c[-1] != '.') { conv_len += (size_t)sprintf(conv + conv_len, "%d", width); }
+            // Negative precision is taken as if it was omitted
+            else if (prec < 0) { --conv_len; }
+            else { conv_len += (size_t)sprintf(conv + conv_len, "%d", prec); }
+        }
+        conv[conv_len] = '\0';
+
+        switch (spec.type)
+        {
+        case __ARG_INT:
+        {
+            int value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_LONG:
+        {
+            long value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_LLONG:
+        {
+            long long value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_INTMAX:
+        {
+            intmax_t value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_SIZE:
+        {
+            size_t value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_PTRDIFF:
+        {
+            ptrdiff_t value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_DOUBLE:
+        {
+            double value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_LDOUBLE:
+        {
+            long double value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_PTR:
+        {
+            void* value;
+            if (!__decode_take(_args, _size, &at, &value, sizeof(value))) { return false; }
+            fprintf(_out, conv, value);
+            break;
+        }
+        case __ARG_STR:
+        {
+            uint32_t value_len;
+            if (!__decode_take(_args, _size, &at, &value_len, sizeof(value_len))
+                || value_len > _size - at)
+            {
+                return false;
+            }
+            char* value = strndup(_args + at, value_len);
+            if (value == NULL) { return false; }
+            at += value_len;
+            fprintf(_out, conv, value);
+            free(value);
+            break;
+        }
+        default:
+            return false;
+        }
+        p = end;
+    }
+    fputc('\n', _out);
+    return true;
+}
+
+
+bool __decode_take(const char* _args, size_t _size, size_t* _at, void* _out, size_t _n)
+{
+    if (_n > _size - *_at) { return false; }
+    memcpy(_out, _args + *_at, _n);
+    *_at += _n;
+    return true;
+}
+
+
+log_res_e __commit_record(const char* _record, size_t _len)
+{
+    if (__tail != NULL) { __tail_publish(_record, _len); }
+    switch (__mode)
+    {
+    case LOG_MODE_ASYNC:
+        return __log_enqueue(_record, _len);
+    case LOG_MODE_MMAP:
+        return __mmap_write(_record, _len);
+    default:
+        return __log_write(_record, _len);
+    }
+}
+
+
+log_res_e __log_write(const char* _record, size_t _len)
+{
+    __stats_t* stats = __stats_local();
+    struct timespec lap;
+    clock_gettime(CLOCK_MONOTONIC, &lap);
+    if (pthread_mutex_lock(&__write_mux) != 0) { return LOG_RES_ERROR_SYNC; }
+    __stats_record(&stats->lock_wait, __stats_lap(&lap));
+    if (__init_ready == false)
+    {
+        pthread_mutex_unlock(&__write_mux);
+        return LOG_RES_ERROR_DUP;
+    }
+
+    struct iovec iov = { .iov_base = (void*)_record, .iov_len = _len };
+    log_res_e ret = __writev_all(__log_fd, &iov, 1);
+    __stats_record(&stats->write, __stats_lap(&lap));
+    __sync_after(1);
+    __rotate_check(_len);
+    pthread_mutex_unlock(&__write_mux);
+
+    return ret;
+}
+
+
+log_res_e __log_enqueue(const char* _record, size_t _len)
+{
+    __thread_ctx_t* ctx = __thread_ctx();
+    if (ctx == NULL) { return LOG_RES_ERROR_OTHER; }
+
+    return __ring_push(ctx, _record, _len);
+}
+
+
+__thread_ctx_t* __thread_ctx(void)
+{
+    unsigned gen = atomic_load_explicit(&__init_gen, memory_order_acquire);
+    if (__tls_ctx != NULL && __tls_gen == gen) { return __tls_ctx; }
+
+    __thread_ctx_t* ctx = (__thread_ctx_t*)calloc(1, sizeof(__thread_ctx_t));
+    if (ctx == NULL) { return NULL; }
+    ctx->ring.buf = (char*)malloc(__ring_size);
+    if (ctx->ring.buf == NULL)
+    {
+        free(ctx);
+        return NULL;
+    }
+    ctx->ring.mask = __ring_size - 1;
+    atomic_init(&ctx->orphan, false);
+    atomic_init(&ctx->ring.head, 0);
+    atomic_init(&ctx->ring.pushed, 0);
+    atomic_init(&ctx->ring.tail, 0);
+
+    // Push to registry - only the head is ever modified concurrently
+    ctx->next = atomic_load_explicit(&__ctx_list, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&__ctx_list, &ctx->next, ctx,
+        memory_order_release, memory_order_relaxed))
+    {
+    }
+    pthread_setspecific(__ctx_key, ctx);
+
+    __tls_ctx = ctx;
+    __tls_gen = gen;
+    return ctx;
+}
+
+
+void __thread_ctx_exit(void* _ctx)
+{
+    __thread_ctx_t* ctx = (__thread_ctx_t*)_ctx;
+    atomic_store_explicit(&ctx->orphan, true, memory_order_release);
+    sem_post(&__flush_sem);
+}
+
+
+log_res_e __ring_push(__thread_ctx_t* _ctx, const char* _record, size_t _len)
+{
+    size_t size = _ctx->ring.mask + 1;
+    size_t head = atomic_load_explicit(&_ctx->ring.head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&_ctx->ring.tail, memory_order_acquire);
+    size_t used = head - tail;
+    if (size - used < _len) { return LOG_RES_DROPPED; }
+
+    // Copy record, splitting it if it wraps around end of buffer
+    size_t at = head & _ctx->ring.mask;
+    size_t first = size - at < _len ? size - at : _len;
+    memcpy(_ctx->ring.buf + at, _record, first);
+    memcpy(_ctx->ring.buf, _record + first, _len - first);
+    atomic_store_explicit(&_ctx->ring.head, head + _len, memory_order_release);
+    atomic_store_explicit(&_ctx->ring.pushed,
+        atomic_load_explicit(&_ctx->ring.pushed, memory_order_relaxed) + 1,
+        memory_order_release);
+
+    // Wake flusher only once per crossing of half capacity
+    if (used < size / 2 && used + _len >= size / 2) { sem_post(&__flush_sem); }
+    return LOG_RES_SUCCESS;
+}
+
+
+size_t __flush_rings(void)
+{
+    struct iovec iov[LOG_FLUSH_IOV_BATCH];
+    struct
+    {
+        __thread_ctx_t* ctx;
+        size_t head;
+    } taken[LOG_FLUSH_IOV_BATCH / 2];
+    int iov_cnt = 0;
+    int taken_cnt = 0;
+    size_t drained = 0;
+    size_t messages = 0;
+    bool synced = false;
+
+    __thread_ctx_t* ctx = atomic_load_explicit(&__ctx_list, memory_order_acquire);
+    while (true)
+    {
+        // Commit batch once it is full, or all rings were visited
+        if (taken_cnt > 0 && (ctx == NULL || taken_cnt == LOG_FLUSH_IOV_BATCH / 2))
+        {
+            struct timespec lap;
+            clock_gettime(CLOCK_MONOTONIC, &lap);
+            if (__flush_uring.fd >= 0) { synced = __flush_submit(iov, iov_cnt, ctx == NULL, messages); }
+            else { __writev_all(__log_fd, iov, iov_cnt); }
+            __stats_record(&__stats_local()->write, __stats_lap(&lap));
+            for (int i = 0; i < taken_cnt; ++i)
+            {
+                atomic_store_explicit(&taken[i].ctx->ring.tail, taken[i].head, memory_order_release);
+            }
+            iov_cnt = 0;
+            taken_cnt = 0;
+        }
+        if (ctx == NULL) { break; }
+
+        // Count is loaded before head, so it never includes messages not yet drained
+        size_t pushed = atomic_load_explicit(&ctx->ring.pushed, memory_order_acquire);
+        size_t head = atomic_load_explicit(&ctx->ring.head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ctx->ring.tail, memory_order_relaxed);
+        messages += pushed - ctx->ring.drained;
+        ctx->ring.drained = pushed;
+        if (head != tail)
+        {
+            size_t size = ctx->ring.mask + 1;
+            size_t at = tail & ctx->ring.mask;
+            size_t len = head - tail;
+            size_t first = size - at < len ? size - at : len;
+            iov[iov_cnt++] = (struct iovec){ .iov_base = ctx->ring.buf + at, .iov_len = first };
+            if (first < len)
+            {
+                iov[iov_cnt++] = (struct iovec){ .iov_base = ctx->ring.buf, .iov_len = len - first };
+            }
+            taken[taken_cnt].ctx = ctx;
+            taken[taken_cnt].head = head;
+            ++taken_cnt;
+            drained += len;
+        }
+        ctx = ctx->next;
+    }
+
+    // Called on every pass, so that `LOG_SYNC_INTERVAL` and time-based rotation
+    // are honored when idle too
+    if (!synced) { __sync_after(messages); }
+    __rotate_check(drained);
+
+    // Free states of exited threads - after exit their rings cannot grow
+    if (__tls_tid == 0) { __tls_tid = (pid_t)syscall(__NR_gettid); }
+    __thread_ctx_t* prev = NULL;
+    ctx = atomic_load_explicit(&__ctx_list, memory_order_acquire);
+    while (ctx != NULL)
+    {
+        __thread_ctx_t* next = ctx->next;
+        if (atomic_load_explicit(&ctx->orphan, memory_order_acquire)
+            && atomic_load_explicit(&ctx->ring.head, memory_order_relaxed)
+            == atomic_load_explicit(&ctx->ring.tail, memory_order_relaxed))
+        {
+            // Sequentially consistent pair with `__crash_flush` - either it waits for state
+            // to be freed, or reclaiming stops here, since crash handler may walk states
+            atomic_store(&__crash_reclaimer, __tls_tid);
+            if (atomic_load(&__crash_active))
+            {
+                atomic_store(&__crash_reclaimer, 0);
+                break;
+            }
+            __thread_ctx_t* expected = ctx;
+            if (prev != NULL) { prev->next = next; }
+            else if (!atomic_compare_exchange_strong_explicit(&__ctx_list, &expected, next,
+                memory_order_acq_rel, memory_order_acquire))
+            {
+                // New state was pushed in meantime - retry during next pass
+                atomic_store(&__crash_reclaimer, 0);
+                prev = ctx;
+                ctx = next;
+                continue;
+            }
+            free(ctx->ring.buf);
+            free(ctx);
+            atomic_store(&__crash_reclaimer, 0);
+            ctx = next;
+            continue;
+        }
+        prev = ctx;
+        ctx = next;
+    }
+
+    return drained;
+}
+
+
+log_res_e __writev_all(int _fd, struct iovec* _iov, int _cnt)
+{
+    while (_cnt > 0)
+    {
+        ssize_t written = writev(_fd, _iov, _cnt);
+        if (written < 0)
+        {
+            if (errno == EINTR) { continue; }
+            return LOG_RES_ERROR_FILE;
+        }
+        while (_cnt > 0 && (size_t)written >= _iov->iov_len)
+        {
+            written -= _iov->iov_len;
+            ++_iov;
+            --_cnt;
+        }
+        if (_cnt > 0)
+        {
+            _iov->iov_base = (char*)_iov->iov_base + written;
+            _iov->iov_len -= written;
+        }
+    }
+    return LOG_RES_SUCCESS;
+}
+
+
+log_res_e __flush_start(void)
+{
+    if (sem_init(&__flush_sem, 0, 0) != 0) { return LOG_RES_ERROR_SYNC; }
+    if ((__errno = pthread_key_create(&__ctx_key, __thread_ctx_exit)) != 0)
+    {
+        sem_destroy(&__flush_sem);
+        errno = __errno;
+        return LOG_RES_ERROR_PTHREAD;
+    }
+    atomic_fetch_add_explicit(&__init_gen, 1, memory_order_acq_rel);
+    atomic_store(&__flush_run, true);
+
+    if ((__errno = pthread_create(&__flush_tid, NULL, __flush_thread, NULL)) != 0)
+    {
+        pthread_key_delete(__ctx_key);
+        sem_destroy(&__flush_sem);
+        errno = __errno;
+        return LOG_RES_ERROR_PTHREAD;
+    }
+    return LOG_RES_SUCCESS;
+}
+
+
+void __flush_stop(void)
+{
+    atomic_store(&__flush_run, false);
+    sem_post(&__flush_sem);
+    pthread_join(__flush_tid, NULL);
+
+    // Destructors of exiting threads must not touch freed states anymore
+    pthread_key_delete(__ctx_key);
+    __thread_ctx_t* ctx = atomic_exchange(&__ctx_list, NULL);
+    while (ctx != NULL)
+    {
+        __thread_ctx_t* next = ctx->next;
+        free(ctx->ring.buf);
+        free(ctx);
+        ctx = next;
+    }
+    sem_destroy(&__flush_sem);
+}
+
+
+size_t __fmt_write_all(int _fd)
+{
+    size_t written = 0;
+    for (size_t i = 0; i < LOG_FMT_TABLE_SIZE; ++i)
+    {
+        __fmt_info_t* info = atomic_load_explicit(&__fmt_table[i], memory_order_acquire);
+        if (info == NULL || !info->deferred) { continue; }
+
+        size_t format_len = strlen(info->format);
+        __rec_head_t head = {
+            .len = (uint32_t)(sizeof(head) + format_len),
+            .type = __REC_DEF,
+            .fmt_id = info->id,
+        };
+        struct iovec iov[2] = {
+            { .iov_base = &head, .iov_len = sizeof(head) },
+            { .iov_base = (void*)info->format, .iov_len = format_len },
+        };
+        if (__writev_all(_fd, iov, 2) == LOG_RES_SUCCESS) { written += head.len; }
+    }
+    return written;
+}
+
+
+void __rotate_check(size_t _written)
+{
+    __log_bytes += _written;
+    // Settings may be changed through control block at any time
+    size_t bytes = atomic_load_explicit(&__control->rotate_bytes, memory_order_relaxed);
+    unsigned interval_s = atomic_load_explicit(&__control->rotate_interval_s, memory_order_relaxed);
+    // Empty or shared LOG file is never rotated
+    if ((bytes == 0 && interval_s == 0) || __log_bytes <= __log_base || __shared) { return; }
+
+    bool due = bytes != 0 && __log_bytes >= bytes;
+    if (!due && interval_s != 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        due = now.tv_sec - __rotate_since >= (time_t)interval_s;
+    }
+    if (due) { __rotate(); }
+}
+
+
+void __rotate(void)
+{
+    // Rotation enabled through control block starts rotation thread on demand
+    if (!__rotate_running && (__rotate_start() != LOG_RES_SUCCESS || !__rotate_running)) { return; }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    __rotate_since = now.tv_sec;
+
+    __rotate_job_t* job = (__rotate_job_t*)malloc(sizeof(__rotate_job_t));
+    if (job == NULL) { return; }
+    memcpy(job->path, __log_name, sizeof(job->path));
+
+    size_t written;
+    int fd = __open_log_file(&written);
+    if (fd < 0 || __change_file_lock(fd, true) != LOG_RES_SUCCESS)
+    {
+        // Keep writing to current LOG file - retried after next interval or write
+        if (fd >= 0) { close(fd); }
+        memcpy(__log_name, job->path, sizeof(__log_name));
+        free(job);
+        return;
+    }
+    memcpy(job->current, __log_name, sizeof(job->current));
+
+    // Swap descriptor - everything else happens on rotation thread
+    job->fd = __log_fd;
+    job->next = NULL;
+    __log_fd = fd;
+    __log_base = written;
+    __log_bytes = written;
+    __sync_pending = 0;
+
+    pthread_mutex_lock(&__rotate_mux);
+    *__rotate_jobs_tail = job;
+    __rotate_jobs_tail = &job->next;
+    pthread_cond_signal(&__rotate_cond);
+    pthread_mutex_unlock(&__rotate_mux);
+}
+
+
+log_res_e __rotate_start(void)
+{
+    if (atomic_load(&__control->rotate_bytes) == 0 && atomic_load(&__control->rotate_interval_s) == 0)
+    {
+        return LOG_RES_SUCCESS;
+    }
+
+    __rotate_run = true;
+    if ((__errno = pthread_create(&__rotate_tid, NULL, __rotate_thread, NULL)) != 0)
+    {
+        errno = __errno;
+        return LOG_RES_ERROR_PTHREAD;
+    }
+    __rotate_running = true;
+    return LOG_RES_SUCCESS;
+}
+
+
+void __rotate_stop(void)
+{
+    if (!__rotate_running) { return; }
+
+    pthread_mutex_lock(&__rotate_mux);
+    __rotate_run = false;
+    pthread_cond_signal(&__rotate_cond);
+    pthread_mutex_unlock(&__rotate_mux);
+    pthread_join(__rotate_tid, NULL);
+    __rotate_running = false;
+}
+
+
+bool __rotate_gzip(const char* _path)
+{
+#ifdef LOG_HAVE_ZLIB
+    char gz_path[PATH_MAX + 3];
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", _path);
+
+    int in_fd = open(_path, O_RDONLY);
+    if (in_fd < 0) { return false; }
+    gzFile out = gzopen(gz_path, "wb");
+    if (out == NULL)
+    {
+        close(in_fd);
+        return false;
+    }
+
+    bool ok = true;
+    char* buf = (char*)malloc(LOG_COMPRESS_BUFFER);
+    ssize_t len = 0;
+    while (buf != NULL && ok && (len = read(in_fd, buf, LOG_COMPRESS_BUFFER)) > 0)
+    {
+        ok = gzwrite(out, buf, (unsigned)len) == (int)len;
+    }
+    ok = ok && buf != NULL && len == 0;
+    free(buf);
+    close(in_fd);
+    ok = gzclose(out) == Z_OK && ok;
+
+    unlink(ok ? _path : gz_path);
+    return ok;
+#else
+    // Without zlib, local `gzip` is spawned (without forking whole process)
+    extern char** environ;
+    char* argv[] = { "gzip", "-f", "--", (char*)_path, NULL };
+    pid_t pid;
+    if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) != 0) { return false; }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR) { return false; }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+
+void __rotate_retain(const char* _current)
+{
+    char dir_path[PATH_MAX];
+    snprintf(dir_path, sizeof(dir_path), "%.*s", (int)__path_len, __path_len ? __path : "/");
+    const char* current = strrchr(_current, '/') + 1;
+    char prefix[3 + sizeof(intmax_t) * 8 + 2];
+    size_t prefix_len = (size_t)sprintf(prefix, "pid%" PRIdMAX "_", (intmax_t)getpid());
+
+    DIR* dir = opendir(dir_path);
+    if (dir == NULL) { return; }
+
+    // Collect rotated LOG files of this process, older than current one
+    struct
+    {
+        char name[256];
+        off_t size;
+    }* files = NULL;
+    size_t files_cnt = 0;
+    size_t files_cap = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        size_t name_len = strlen(entry->d_name);
+        bool is_log = (name_len > 4 && strcmp(entry->d_name + name_len - 4, ".LOG") == 0)
+            || (name_len > 7 && strcmp(entry->d_name + name_len - 7, ".LOG.gz") == 0);
+        struct stat entry_stat;
+        // (names of instances, which start with letter, follow PID of LOG files of instances)
+        if (!is_log
+            || strncmp(entry->d_name, prefix, prefix_len) != 0
+            || !isdigit((unsigned char)entry->d_name[prefix_len])
+            || strcmp(entry->d_name, current) >= 0
+            || name_len >= sizeof(files->name)
+            || fstatat(dirfd(dir), entry->d_name, &entry_stat, 0) != 0)
+        {
+            continue;
+        }
+        if (files_cnt == files_cap)
+        {
+            files_cap = files_cap ? files_cap * 2 : 16;
+            void* grown = realloc(files, files_cap * sizeof(*files));
+            if (grown == NULL) { break; }
+            files = grown;
+        }
+        memcpy(files[files_cnt].name, entry->d_name, name_len + 1);
+        files[files_cnt].size = entry_stat.st_size;
+        ++files_cnt;
+    }
+
+    // Names sort chronologically - sort newest first (insertion sort, lists are short)
+    for (size_t i = 1; i < files_cnt; ++i)
+    {
+        for (size_t j = i; j > 0 && strcmp(files[j - 1].name, files[j].name) < 0; --j)
+        {
+            char name[sizeof(files->name)];
+            off_t size = files[j].size;
+            memcpy(name, files[j].name, sizeof(name));
+            memcpy(files[j].name, files[j - 1].name, sizeof(name));
+            files[j].size = files[j - 1].size;
+            memcpy(files[j - 1].name, name, sizeof(name));
+            files[j - 1].size = size;
+        }
+    }
+
+    size_t kept_bytes = 0;
+    for (size_t i = 0; i < files_cnt; ++i)
+    {
+        kept_bytes += (size_t)files[i].size;
+        if ((__retain_segments != 0 && i >= __retain_segments)
+            || (__retain_bytes != 0 && kept_bytes > __retain_bytes))
+        {
+            unlinkat(dirfd(dir), files[i].name, 0);
+        }
+    }
+
+    free(files);
+    closedir(dir);
+}
+
+
+void* __rotate_thread(void* _)
+{
+    pthread_mutex_lock(&__rotate_mux);
+    while (true)
+    {
+        while (__rotate_jobs == NULL && __rotate_run)
+        {
+            pthread_cond_wait(&__rotate_cond, &__rotate_mux);
+        }
+        __rotate_job_t* job = __rotate_jobs;
+        if (job == NULL) { break; }
+        __rotate_jobs = job->next;
+        if (__rotate_jobs == NULL) { __rotate_jobs_tail = &__rotate_jobs; }
+        pthread_mutex_unlock(&__rotate_mux);
+
+        if ((__control->sync & ((1 << LOG_SYNC_POLICY_BITS) - 1)) != LOG_SYNC_NONE) { fsync(job->fd); }
+        // Rotated LOG file is no longer written - drop mandatory locking bit
+        // (`gzip` refuses to compress set-group-ID files)
+        __change_file_lock(job->fd, false);
+        fchmod(job->fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+        close(job->fd);
+        if (__rotate_compress) { __rotate_gzip(job->path); }
+        if (__retain_segments != 0 || __retain_bytes != 0) { __rotate_retain(job->current); }
+        free(job);
+
+        pthread_mutex_lock(&__rotate_mux);
+    }
+    pthread_mutex_unlock(&__rotate_mux);
+    return NULL;
+}
+
+
+void __writer_stop(void)
+{
+    if (__mode == LOG_MODE_ASYNC) { __flush_stop(); }
+    else if (__mode == LOG_MODE_MMAP) { __mmap_stop(); }
+    __rotate_stop();
+}
+
+
+log_res_e __mmap_start(void)
+{
+    // Mapping starts at offset 0, so that header of binary LOG file is kept
+    off_t size = lseek(__log_fd, 0, SEEK_END);
+    if (size < 0) { return LOG_RES_ERROR_FILE; }
+
+    for (size_t i = 0; i < LOG_MMAP_MAX_CHUNKS; ++i)
+    {
+        atomic_init(&__mmap_chunks[i].addr, NULL);
+        atomic_init(&__mmap_chunks[i].committed, 0);
+    }
+    atomic_init(&__mmap_chunks[0].committed, (size_t)size);
+    atomic_init(&__mmap_offset, (size_t)size);
+    atomic_init(&__mmap_synced, (size_t)size);
+    atomic_init(&__mmap_messages, 0);
+    atomic_init(&__mmap_last_sync, 0);
+
+    if (__mmap_map(0) == NULL) { return LOG_RES_ERROR_FILE; }
+    return LOG_RES_SUCCESS;
+}
+
+
+void __mmap_stop(void)
+{
+    // Without `__write_mux`, only quiescence tells that nobody copies into chunks anymore
+    __writer_quiesce();
+    int sync_policy = __control->sync & ((1 << LOG_SYNC_POLICY_BITS) - 1);
+    for (size_t i = 0; i < LOG_MMAP_MAX_CHUNKS; ++i)
+    {
+        char* addr = atomic_exchange(&__mmap_chunks[i].addr, NULL);
+        if (addr == NULL) { continue; }
+        if (sync_policy != LOG_SYNC_NONE) { msync(addr, __mmap_chunk, MS_SYNC); }
+        munmap(addr, __mmap_chunk);
+    }
+    // Drop preallocated, but unused tail of LOG file
+    ftruncate(__log_fd, (off_t)atomic_load(&__mmap_offset));
+}
+
+
+log_res_e __mmap_write(const char* _record, size_t _len)
+{
+    size_t offset = atomic_fetch_add_explicit(&__mmap_offset, _len, memory_order_relaxed);
+    log_res_e ret = LOG_RES_SUCCESS;
+    // Record may span multiple chunks - copy it piecewise
+    for (size_t copied = 0; copied < _len; )
+    {
+        size_t at = offset + copied;
+        size_t idx = at / __mmap_chunk;
+        size_t in_chunk = at % __mmap_chunk;
+        size_t n = _len - copied < __mmap_chunk - in_chunk ? _len - copied : __mmap_chunk - in_chunk;
+
+        char* addr = idx < LOG_MMAP_MAX_CHUNKS ? __mmap_map(idx) : NULL;
+        if (addr != NULL) { memcpy(addr + in_chunk, _record + copied, n); }
+        else { ret = LOG_RES_ERROR_FILE; }
+        if (idx < LOG_MMAP_MAX_CHUNKS) { __mmap_commit(idx, n); }
+        copied += n;
+    }
+
+    if (ret == LOG_RES_SUCCESS) { __mmap_sync_after(offset, _len); }
+    return ret;
+}
+
+
+char* __mmap_map(size_t _idx)
+{
+    char* addr = atomic_load_explicit(&__mmap_chunks[_idx].addr, memory_order_acquire);
+    if (addr != NULL) { return addr; }
+
+    pthread_mutex_lock(&__mmap_mux);
+    addr = atomic_load_explicit(&__mmap_chunks[_idx].addr, memory_order_acquire);
+    if (addr == NULL)
+    {
+        off_t offset = (off_t)(_idx * __mmap_chunk);
+        void* mapped = MAP_FAILED;
+        if (posix_fallocate(__log_fd, offset, (off_t)__mmap_chunk) == 0)
+        {
+            mapped = mmap(NULL, __mmap_chunk, PROT_READ | PROT_WRITE, MAP_SHARED, __log_fd, offset);
+        }
+        if (mapped != MAP_FAILED)
+        {
+            addr = (char*)mapped;
+            atomic_store_explicit(&__mmap_chunks[_idx].addr, addr, memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&__mmap_mux);
+    return addr;
+}
+
+
+void __mmap_commit(size_t _idx, size_t _len)
+{
+    size_t committed = atomic_fetch_add_explicit(&__mmap_chunks[_idx].committed, _len,
+        memory_order_acq_rel) + _len;
+    if (committed < __mmap_chunk) { return; }
+
+    // Every reservation in chunk was copied - nobody touches it anymore
+    char* addr = atomic_exchange(&__mmap_chunks[_idx].addr, NULL);
+    if (addr == NULL) { return; }
+    if ((__control->sync & ((1 << LOG_SYNC_POLICY_BITS) - 1)) != LOG_SYNC_NONE)
+    {
+        msync(addr, __mmap_chunk, MS_SYNC);
+    }
+    munmap(addr, __mmap_chunk);
+}
+
+
+void __mmap_msync(size_t _from, size_t _to)
+{
+    struct timespec lap;
+    clock_gettime(CLOCK_MONOTONIC, &lap);
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t idx = _from / __mmap_chunk;
+        idx <= (_to - 1) / __mmap_chunk && idx < LOG_MMAP_MAX_CHUNKS;
+        ++idx)
+    {
+        char* addr = atomic_load_explicit(&__mmap_chunks[idx].addr, memory_order_acquire);
+        // Retired chunks were synced before being unmapped
+        if (addr == NULL) { continue; }
+
+        size_t chunk_start = idx * __mmap_chunk;
+        size_t from = _from > chunk_start ? _from - chunk_start : 0;
+        size_t to = _to - chunk_start < __mmap_chunk ? _to - chunk_start : __mmap_chunk;
+        from = from / page_size * page_size;
+        msync(addr + from, to - from, MS_SYNC);
+    }
+    __stats_record(&__stats_local()->sync, __stats_lap(&lap));
+}
+
+
+void __mmap_sync_after(size_t _offset, size_t _len)
+{
+    int cfg = __control->sync;
+    unsigned param = (unsigned)cfg >> LOG_SYNC_POLICY_BITS;
+    switch ((log_sync_e)(cfg & ((1 << LOG_SYNC_POLICY_BITS) - 1)))
+    {
+    case LOG_SYNC_MESSAGE:
+    case LOG_SYNC_DATA:
+        __mmap_msync(_offset, _offset + _len);
+        return;
+    case LOG_SYNC_COUNT:
+        if ((atomic_fetch_add_explicit(&__mmap_messages, 1, memory_order_relaxed) + 1) % param != 0)
+        {
+            return;
+        }
+        break;
+    case LOG_SYNC_INTERVAL:
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+        long long last_ns = atomic_load_explicit(&__mmap_last_sync, memory_order_relaxed);
+        // Only thread that advances time of last sync performs it
+        if (now_ns - last_ns < (long long)param * 1000000LL
+            || !atomic_compare_exchange_strong(&__mmap_last_sync, &last_ns, now_ns))
+        {
+            return;
+        }
+        break;
+    }
+    default:
+        return;
+    }
+
+    // Sync everything reserved since last sync
+    size_t to = _offset + _len;
+    size_t from = atomic_exchange(&__mmap_synced, to);
+    if (from < to) { __mmap_msync(from, to); }
+}
+
+
+void* __flush_thread(void* _)
+{
+    if (__io_uring && __uring_setup(&__flush_uring) == LOG_RES_SUCCESS)
+    {
+        __uring_register_file(&__flush_uring, __log_fd);
+    }
+
+    while (atomic_load(&__flush_run))
+    {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += __flush_interval_ms / 1000;
+        until.tv_nsec += (long)(__flush_interval_ms % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L)
+        {
+            ++until.tv_sec;
+            until.tv_nsec -= 1000000000L;
+        }
+        while (sem_timedwait(&__flush_sem, &until) != 0 && errno == EINTR) {}
+
+        __flush_rings();
+    }
+    // Drain messages pushed before stop was requested
+    __flush_rings();
+    __uring_teardown(&__flush_uring);
+    return NULL;
+}
+
+
+char* __proc_getline(__proc_reader_t* _reader)
+{
+    while (true)
+    {
+        char* line = _reader->data + _reader->pos;
+        char* newline = memchr(line, '\n', _reader->len - _reader->pos);
+        if (newline != NULL)
+        {
+            *newline = '\0';
+            _reader->pos = (size_t)(newline - _reader->data) + 1;
+            return line;
+        }
+
+        // Move incomplete line to front of buffer and read more
+        size_t rest = _reader->len - _reader->pos;
+        if (rest == sizeof(_reader->data) - 1)
+        {
+            // Line longer than buffer - cut it
+            _reader->data[rest] = '\0';
+            _reader->pos = _reader->len = 0;
+            return _reader->data;
+        }
+        memmove(_reader->data, line, rest);
+        _reader->pos = 0;
+        _reader->len = rest;
+        ssize_t len;
+        while ((len = read(_reader->fd, _reader->data + rest, sizeof(_reader->data) - 1 - rest)) < 0
+            && errno == EINTR)
+        { }
+        if (len <= 0)
+        {
+            if (rest == 0) { return NULL; }
+            _reader->data[rest] = '\0';
+            _reader->len = 0;
+            return _reader->data;
+        }
+        _reader->len += (size_t)len;
+    }
+}
+
+
+void __dump_put(__dump_writer_t* _writer, const char* _data, size_t _len)
+{
+    if (_writer->len + _len > sizeof(_writer->data)) { __dump_flush(_writer); }
+    if (_len > sizeof(_writer->data))
+    {
+        struct iovec iov = { .iov_base = (void*)_data, .iov_len = _len };
+        if (__writev_all(_writer->fd, &iov, 1) != LOG_RES_SUCCESS) { _writer->failed = true; }
+        return;
+    }
+    memcpy(_writer->data + _writer->len, _data, _len);
+    _writer->len += _len;
+}
+
+
+void __dump_printf(__dump_writer_t* _writer, const char* _format, ...)
+{
+    char line[PATH_MAX + 256];
+    va_list args;
+    va_start(args, _format);
+    int len = vsnprintf(line, sizeof(line), _format, args);
+    va_end(args);
+    if (len < 0) { return; }
+    if ((size_t)len >= sizeof(line)) { len = sizeof(line) - 1; }
+    __dump_put(_writer, line, (size_t)len);
+}
+
+
+void __dump_flush(__dump_writer_t* _writer)
+{
+    if (_writer->len == 0) { return; }
+    struct iovec iov = { .iov_base = _writer->data, .iov_len = _writer->len };
+    log_res_e ret = LOG_RES_ERROR_OTHER;
+    if (__tls_uring != NULL && __tls_uring->fd >= 0)
+    {
+        // Failed ring is given up, and buffer is written again with `writev`
+        ret = __uring_write(__tls_uring, _writer->fd, &iov, 1, false, false);
+        if (ret == LOG_RES_ERROR_OTHER) { __uring_teardown(__tls_uring); }
+    }
+    if (ret == LOG_RES_ERROR_OTHER) { ret = __writev_all(_writer->fd, &iov, 1); }
+    if (ret != LOG_RES_SUCCESS) { _writer->failed = true; }
+    _writer->len = 0;
+}
+
+
+bool __dump_parse_region(char* _line, __dump_region_t* _region)
+{
+    // `start-end perms offset major:minor inode [mapping]`
+    char* end;
+    _region->start = strtoumax(_line, &end, 16);
+    if (end == _line || *end != '-') { return false; }
+    _region->end = strtoumax(end + 1, &end, 16);
+    if (*end != ' ') { return false; }
+    char* field = end + 1;
+    memcpy(_region->perms, field, 4);
+    _region->perms[4] = '\0';
+    _region->offset = strtoumax(field + 5, &end, 16);
+    field = end + 1;
+    size_t device_len = strcspn(field, " ");
+    if (device_len >= sizeof(_region->device)) { device_len = sizeof(_region->device) - 1; }
+    memcpy(_region->device, field, device_len);
+    _region->device[device_len] = '\0';
+    _region->inode = strtoumax(field + device_len, &end, 10);
+    while (*end == ' ') { ++end; }
+    _region->mapping = *end ? end : "[ anon ]";
+    memset(_region->fields, 0, sizeof(_region->fields));
+    _region->vm_flags[0] = '\0';
+    return true;
+}
+
+
+void __dump_region(__dump_writer_t* _writer, log_dump_lvl_e _lvl,
+    const __dump_smaps_t* _smaps, const __dump_region_t* _region)
+{
+    // Indices of counters shown by `LOG_DUMP_LVL_DETAIL`
+    size_t size_i = LOG_DUMP_MAX_FIELDS;
+    size_t rss_i = LOG_DUMP_MAX_FIELDS;
+    size_t dirty_i[2] = { LOG_DUMP_MAX_FIELDS, LOG_DUMP_MAX_FIELDS };
+    for (size_t i = 0; i < _smaps->count; ++i)
+    {
+        if (strcmp(_smaps->names[i], "Size") == 0) { size_i = i; }
+        else if (strcmp(_smaps->names[i], "Rss") == 0) { rss_i = i; }
+        else if (strcmp(_smaps->names[i], "Shared_Dirty") == 0) { dirty_i[0] = i; }
+        else if (strcmp(_smaps->names[i], "Private_Dirty") == 0) { dirty_i[1] = i; }
+    }
+
+    if (_region == NULL)
+    {
+        switch (_lvl)
+        {
+        case LOG_DUMP_LVL_NORMAL:
+            __dump_printf(_writer, "%-16s %10s %-5s %s\n", "Address", "Kbytes", "Mode", "Mapping");
+            break;
+        case LOG_DUMP_LVL_DETAIL:
+            __dump_printf(_writer, "%-16s %10s %10s %10s %-5s %s\n",
+                "Address", "Kbytes", "RSS", "Dirty", "Mode", "Mapping");
+            break;
+        default:
+            __dump_printf(_writer, "%-16s %-4s %-8s %-6s %-10s",
+                "Address", "Perm", "Offset", "Device", "Inode");
+            for (size_t i = 0; i < _smaps->count; ++i)
+            {
+                __dump_printf(_writer, " %*s", strlen(_smaps->names[i]) > 8
+                    ? (int)strlen(_smaps->names[i]) : 8, _smaps->names[i]);
+            }
+            if (_lvl == LOG_DUMP_LVL_FULL) { __dump_printf(_writer, " %-24s", "VmFlags"); }
+            __dump_printf(_writer, " %s\n", "Mapping");
+            break;
+        }
+        return;
+    }
+
+    uintmax_t size = (_region->end - _region->start) / 1024;
+    switch (_lvl)
+    {
+    case LOG_DUMP_LVL_NORMAL:
+        __dump_printf(_writer, "%016" PRIxMAX " %9" PRIuMAX "K %-5s %s\n",
+            _region->start, size, _region->perms, _region->mapping);
+        break;
+    case LOG_DUMP_LVL_DETAIL:
+        __dump_printf(_writer, "%016" PRIxMAX " %10" PRIuMAX " %10" PRIuMAX " %10" PRIuMAX " %-5s %s\n",
+            _region->start,
+            size_i < _smaps->count ? _region->fields[size_i] : size,
+            rss_i < _smaps->count ? _region->fields[rss_i] : 0,
+            (dirty_i[0] < _smaps->count ? _region->fields[dirty_i[0]] : 0)
+                + (dirty_i[1] < _smaps->count ? _region->fields[dirty_i[1]] : 0),
+            _region->perms, _region->mapping);
+        break;
+    default:
+        __dump_printf(_writer, "%016" PRIxMAX " %-4s %08" PRIxMAX " %-6s %-10" PRIuMAX,
+            _region->start, _region->perms, _region->offset, _region->device, _region->inode);
+        for (size_t i = 0; i < _smaps->count; ++i)
+        {
+            __dump_printf(_writer, " %*" PRIuMAX, strlen(_smaps->names[i]) > 8
+                ? (int)strlen(_smaps->names[i]) : 8, _region->fields[i]);
+        }
+        if (_lvl == LOG_DUMP_LVL_FULL) { __dump_printf(_writer, " %-24s", _region->vm_flags); }
+        __dump_printf(_writer, " %s\n", _region->mapping);
+        break;
+    }
+}
+
+
+log_res_e __dump_render(__dump_writer_t* _writer, log_dump_lvl_e _lvl)
+{
+    __proc_reader_t* reader = (__proc_reader_t*)malloc(sizeof(__proc_reader_t));
+    if (reader == NULL) { return LOG_RES_ERROR_FILE; }
+    reader->pos = reader->len = 0;
+
+    // Basic DUMP needs only `maps`, others read counters of every region from `smaps`
+    reader->fd = open(_lvl == LOG_DUMP_LVL_NORMAL ? "/proc/self/maps" : "/proc/self/smaps", O_RDONLY);
+    if (reader->fd < 0)
+    {
+        free(reader);
+        return LOG_RES_ERROR_FILE;
+    }
+
+    __dump_smaps_t smaps = { .count = 0, .complete = false };
+    __dump_region_t region;
+    char mapping[PATH_MAX];
+    uintmax_t totals[LOG_DUMP_MAX_FIELDS] = { 0 };
+    uintmax_t total_size = 0;
+    bool pending = false;
+    char* line;
+    do
+    {
+        line = __proc_getline(reader);
+        __dump_region_t next;
+        bool is_region = line != NULL && __dump_parse_region(line, &next);
+
+        if (line != NULL && !is_region)
+        {
+            // `Name:   value kB` counter, or `VmFlags: ..`
+            char* colon = strchr(line, ':');
+            if (colon == NULL || !pending) { continue; }
+            *colon = '\0';
+            char* value = colon + 1;
+            while (*value == ' ') { ++value; }
+            if (strcmp(line, "VmFlags") == 0)
+            {
+                snprintf(region.vm_flags, sizeof(region.vm_flags), "%s", value);
+                continue;
+            }
+            char* value_end;
+            uintmax_t number = strtoumax(value, &value_end, 10);
+            if (value_end == value || strcmp(value_end, " kB") != 0) { continue; }
+
+            // Counters are listed in same order for every region
+            size_t i = 0;
+            while (i < smaps.count && strcmp(smaps.names[i], line) != 0) { ++i; }
+            if (i == smaps.count)
+            {
+                if (smaps.complete || smaps.count == LOG_DUMP_MAX_FIELDS) { continue; }
+                snprintf(smaps.names[i], sizeof(smaps.names[i]), "%s", line);
+                ++smaps.count;
+            }
+            region.fields[i] = number;
+            continue;
+        }
+
+        // Region is complete once next one starts (or file ends)
+        if (pending)
+        {
+            if (!smaps.complete)
+            {
+                smaps.complete = true;
+                __dump_region(_writer, _lvl, &smaps, NULL);
+            }
+            __dump_region(_writer, _lvl, &smaps, &region);
+            total_size += (region.end - region.start) / 1024;
+            for (size_t i = 0; i < smaps.count; ++i) { totals[i] += region.fields[i]; }
+        }
+        if (is_region)
+        {
+            region = next;
+            // Mapping points into reader buffer, which is overwritten by following lines
+            snprintf(mapping, sizeof(mapping), "%s", next.mapping);
+            region.mapping = mapping;
+            pending = true;
+        }
+    } while (line != NULL);
+    close(reader->fd);
+
+    // Totals
+    __dump_printf(_writer, "%s\n", "----------------");
+    switch (_lvl)
+    {
+    case LOG_DUMP_LVL_NORMAL:
+        __dump_printf(_writer, "%-16s %9" PRIuMAX "K\n", " total", total_size);
+        break;
+    case LOG_DUMP_LVL_DETAIL:
+    {
+        uintmax_t rss = 0;
+        uintmax_t dirty = 0;
+        for (size_t i = 0; i < smaps.count; ++i)
+        {
+            if (strcmp(smaps.names[i], "Rss") == 0) { rss = totals[i]; }
+            else if (strstr(smaps.names[i], "_Dirty") != NULL) { dirty += totals[i]; }
+        }
+        __dump_printf(_writer, "%-16s %10" PRIuMAX " %10" PRIuMAX " %10" PRIuMAX "\n",
+            " total kB", total_size, rss, dirty);
+        break;
+    }
+    default:
+        __dump_printf(_writer, "%-16s %-4s %-8s %-6s %-10s", " total kB", "", "", "", "");
+        for (size_t i = 0; i < smaps.count; ++i)
+        {
+            __dump_printf(_writer, " %*" PRIuMAX, strlen(smaps.names[i]) > 8
+                ? (int)strlen(smaps.names[i]) : 8, totals[i]);
+        }
+        __dump_printf(_writer, "%s\n", "");
+        break;
+    }
+
+    // Full DUMP ends with totals computed by kernel (precise PSS)
+    if (_lvl == LOG_DUMP_LVL_FULL
+        && (reader->fd = open("/proc/self/smaps_rollup", O_RDONLY)) >= 0)
+    {
+        reader->pos = reader->len = 0;
+        __dump_printf(_writer, "\n%s\n", "smaps_rollup:");
+        while ((line = __proc_getline(reader)) != NULL) { __dump_printf(_writer, "%s\n", line); }
+        close(reader->fd);
+    }
+
+    free(reader);
+    __dump_flush(_writer);
+    return _writer->failed ? LOG_RES_ERROR_FILE : LOG_RES_SUCCESS;
+}
+
+
+void __dump_providers_run(__dump_writer_t* _writer, log_dump_lvl_e _lvl)
+{
+    // Snapshot registry in priority order, so that it is not locked while providers run
+    __dump_job_t* jobs[LOG_DUMP_MAX_PROVIDERS];
+    size_t jobs_cnt = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&__dump_providers_mux);
+    for (size_t i = 0; i < LOG_DUMP_MAX_PROVIDERS; ++i)
+    {
+        __dump_provider_t* slot = &__dump_providers[i];
+        if (slot->provider == NULL) { continue; }
+
+        __dump_job_t* job = (__dump_job_t*)calloc(1, sizeof(__dump_job_t));
+        if (job == NULL) { break; }
+        memcpy(job->provider.name, slot->name, sizeof(job->provider.name));
+        job->provider.provider = slot->provider;
+        job->provider.ctx = slot->ctx;
+        job->provider.priority = slot->priority;
+        job->provider.timeout_ms = slot->timeout_ms;
+        job->running = &slot->running;
+        job->lvl = _lvl;
+        job->deadline.tv_sec = now.tv_sec + (time_t)(slot->timeout_ms / 1000);
+        job->deadline.tv_nsec = now.tv_nsec + (long)(slot->timeout_ms % 1000) * 1000000;
+        if (job->deadline.tv_nsec >= 1000000000)
+        {
+            job->deadline.tv_nsec -= 1000000000;
+            ++job->deadline.tv_sec;
+        }
+
+        size_t at = jobs_cnt++;
+        while (at > 0 && jobs[at - 1]->provider.priority < job->provider.priority)
+        {
+            jobs[at] = jobs[at - 1];
+            --at;
+        }
+        jobs[at] = job;
+    }
+    pthread_mutex_unlock(&__dump_providers_mux);
+
+    // Launch all providers at once - slow one delays only its own section
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    for (size_t i = 0; i < jobs_cnt; ++i)
+    {
+        __dump_job_t* job = jobs[i];
+        pthread_mutex_init(&job->mux, NULL);
+        pthread_cond_init(&job->cond, &cond_attr);
+        job->refs = 1;
+        // Provider still running from previous DUMP is not run again
+        if (atomic_fetch_add(job->running, 1) != 0)
+        {
+            atomic_fetch_sub(job->running, 1);
+            job->running = NULL;
+            continue;
+        }
+
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        job->refs = 2;
+        if (pthread_create(&tid, &attr, __dump_job_thread, job) != 0)
+        {
+            atomic_fetch_sub(job->running, 1);
+            job->refs = 1;
+            job->done = true;
+            log_dump_printf(&job->writer, "%s\n", "[cannot create thread for provider]");
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_condattr_destroy(&cond_attr);
+
+    for (size_t i = 0; i < jobs_cnt; ++i)
+    {
+        __dump_job_t* job = jobs[i];
+        __dump_printf(_writer, "\n=== %s ===\n", job->provider.name);
+        if (job->running == NULL)
+        {
+            __dump_printf(_writer, "%s\n", "[skipped - still running for previous DUMP]");
+            __dump_job_release(job);
+            continue;
+        }
+
+        pthread_mutex_lock(&job->mux);
+        int ret = 0;
+        while (!job->done && ret != ETIMEDOUT)
+        {
+            ret = pthread_cond_timedwait(&job->cond, &job->mux, &job->deadline);
+        }
+        if (job->done)
+        {
+            __dump_put(_writer, job->writer.data, job->writer.len);
+            if (job->writer.len && job->writer.data[job->writer.len - 1] != '\n')
+            {
+                __dump_put(_writer, "\n", 1);
+            }
+            if (job->writer.truncated) { __dump_printf(_writer, "%s\n", "[truncated]"); }
+        }
+        else
+        {
+            __dump_printf(_writer, "[timed out after %u ms]\n", job->provider.timeout_ms);
+        }
+        pthread_mutex_unlock(&job->mux);
+        __dump_job_release(job);
+    }
+}
+
+
+void __dump_job_release(__dump_job_t* _job)
+{
+    pthread_mutex_lock(&_job->mux);
+    int refs = --_job->refs;
+    pthread_mutex_unlock(&_job->mux);
+    if (refs != 0) { return; }
+
+    pthread_cond_destroy(&_job->cond);
+    pthread_mutex_destroy(&_job->mux);
+    free(_job->writer.data);
+    free(_job);
+}
+
+
+void* __dump_job_thread(void* _job)
+{
+    __dump_job_t* job = (__dump_job_t*)_job;
+    // Output of abandoned provider is discarded, so it writes to its own buffer
+    job->provider.provider(&job->writer, job->lvl, job->provider.ctx);
+    atomic_fetch_sub(job->running, 1);
+
+    pthread_mutex_lock(&job->mux);
+    job->done = true;
+    pthread_cond_signal(&job->cond);
+    pthread_mutex_unlock(&job->mux);
+    __dump_job_release(job);
+    return NULL;
+}
+
+
+void __dump_header(__dump_writer_t* _writer, const __dump_cmd_t* _cmd, unsigned _coalesced)
+{
+    static const char* lvl_names[] = { "NORMAL", "DETAIL", "EXTENDED", "FULL" };
+
+    // `PID:   command line`
+    char cmdline[256];
+    ssize_t len = -1;
+    int fd = open("/proc/self/cmdline", O_RDONLY);
+    if (fd >= 0)
+    {
+        len = read(fd, cmdline, sizeof(cmdline));
+        close(fd);
+    }
+    for (ssize_t i = 0; i < len - 1; ++i)
+    {
+        if (cmdline[i] == '\0') { cmdline[i] = ' '; }
+    }
+    __dump_printf(_writer, "%" PRIdMAX ":   %.*s\n",
+        (intmax_t)getpid(), len > 0 ? (int)len : 0, cmdline);
+    if (_cmd->kind == LOG_STATS_KIND) { __dump_printf(_writer, "# STATS #%u", _cmd->seq); }
+    else { __dump_printf(_writer, "# %s DUMP #%u", lvl_names[_cmd->lvl], _cmd->seq); }
+    __dump_printf(_writer, " ordered by PID %" PRIdMAX " (UID %" PRIdMAX ")",
+        (intmax_t)_cmd->pid, (intmax_t)_cmd->uid);
+    if (_coalesced) { __dump_printf(_writer, ", merged with %u later orders", _coalesced); }
+    __dump_put(_writer, "\n", 1);
+}
+
+
+void __dump_create(const __dump_cmd_t* _cmd, unsigned _coalesced)
+{
+    static const char* lvl_names[] = { "NORMAL", "DETAIL", "EXTENDED", "FULL" };
+
+    struct timespec lap;
+    clock_gettime(CLOCK_MONOTONIC, &lap);
+    __dump_writer_t* writer = __dump_writer;
+    char* dump_path = NULL;
+    int fd = writer != NULL ? __dump_open("DUMP", &dump_path) : -1;
+    if (fd < 0)
+    {
+        log_printf(LOG_LVL_MIN, "Failed to create DUMP file: %s", strerror(errno));
+        free(dump_path);
+        return;
+    }
+
+    writer->fd = fd;
+    writer->failed = false;
+    writer->len = 0;
+    __dump_header(writer, _cmd, _coalesced);
+    log_res_e ret = LOG_RES_SUCCESS;
+    if (_cmd->sections & LOG_DUMP_SECTION_MAP) { ret = __dump_render(writer, _cmd->lvl); }
+    if (ret == LOG_RES_SUCCESS && (_cmd->sections & LOG_DUMP_SECTION_PROVIDERS))
+    {
+        __dump_providers_run(writer, _cmd->lvl);
+    }
+    if (ret == LOG_RES_SUCCESS && __flight_size != 0 && (_cmd->sections & LOG_DUMP_SECTION_FLIGHT))
+    {
+        __flight_render(writer);
+    }
+    __dump_flush(writer);
+    if (ret == LOG_RES_SUCCESS && writer->failed) { ret = LOG_RES_ERROR_FILE; }
+    close(fd);
+    __stats_record(&__stats_local()->dump, __stats_lap(&lap));
+    if (ret != LOG_RES_SUCCESS)
+    {
+        log_printf(LOG_LVL_MIN, "Failed to create %s DUMP file [%s]: error code [%d]",
+            lvl_names[_cmd->lvl], dump_path, ret);
+    }
+    else
+    {
+        log_printf(LOG_LVL_MIN, "Created %s DUMP file [%s] ordered by PID %" PRIdMAX,
+            lvl_names[_cmd->lvl], dump_path, (intmax_t)_cmd->pid);
+    }
+    free(dump_path);
+}
+
+
+void __stats_create(const __dump_cmd_t* _cmd, unsigned _coalesced)
+{
+    __dump_writer_t* writer = __dump_writer;
+    char* stats_path = NULL;
+    int fd = writer != NULL ? __dump_open("STATS", &stats_path) : -1;
+    if (fd < 0)
+    {
+        log_printf(LOG_LVL_MIN, "Failed to create STATS file: %s", strerror(errno));
+        free(stats_path);
+        return;
+    }
+
+    log_stats_t stats;
+    log_stats(&stats);
+    writer->fd = fd;
+    writer->failed = false;
+    writer->len = 0;
+    __dump_header(writer, _cmd, _coalesced);
+    __dump_printf(writer,
+        "\n"
+        "messages_accepted   %llu\n"
+        "messages_ignored    %llu\n"
+        "messages_dropped    %llu\n"
+        "messages_suppressed %llu\n"
+        "messages_failed     %llu\n"
+        "bytes_accepted      %llu\n"
+        "threads             %u\n",
+        stats.accepted, stats.ignored, stats.dropped, stats.suppressed, stats.failed, stats.bytes,
+        stats.threads);
+    __dump_printf(writer, "\n# Latency [ns] - percentiles are upper bounds of power-of-2 buckets\n");
+    __stats_hist_print(writer, "write", &stats.write);
+    __stats_hist_print(writer, "sync", &stats.sync);
+    __stats_hist_print(writer, "lock_wait", &stats.lock_wait);
+    __stats_hist_print(writer, "dump", &stats.dump);
+    __dump_flush(writer);
+    close(fd);
+    if (writer->failed)
+    {
+        log_printf(LOG_LVL_MIN, "Failed to write STATS file [%s]", stats_path);
+    }
+    else
+    {
+        log_printf(LOG_LVL_MIN, "Created STATS file [%s] ordered by PID %" PRIdMAX,
+            stats_path, (intmax_t)_cmd->pid);
+    }
+    free(stats_path);
+}
+
+
+int __dump_open(const char* _extension, char** _path)
+{
+    // Files ordered within same second are numbered
+    int fd = -1;
+    *_path = NULL;
+    for (unsigned seq = 0; fd < 0 && seq < LOG_MAX_NAME_SEQ; ++seq)
+    {
+        free(*_path);
+        *_path = __create_file_name(NULL, _extension, seq);
+        fd = open(*_path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd < 0 && errno != EEXIST) { break; }
+    }
+    return fd;
+}
+
+
+void __dump_order(unsigned _kind, __dump_cmd_t _cmd)
+{
+    // Order of same kind is already waiting - merge with it
+    if (atomic_fetch_or(&__dump_pending, 1ull << _kind) & (1ull << _kind))
+    {
+        atomic_fetch_add(&__dump_coalesced[_kind], 1);
+        return;
+    }
+
+    _cmd.kind = _kind;
+    _cmd.seq = atomic_fetch_add(&__dump_seq, 1) + 1;
+    if (!__dump_queue_push(&_cmd))
+    {
+        atomic_fetch_and(&__dump_pending, ~(1ull << _kind));
+        return;
+    }
+
+    // Signal action must not clobber `errno` of interrupted code
+    int saved_errno = errno;
+    uint64_t wake = 1;
+    write(__dump_event, &wake, sizeof(wake));
+    errno = saved_errno;
+}
+
+
+bool __dump_queue_push(const __dump_cmd_t* _cmd)
+{
+    size_t pos = atomic_load_explicit(&__dump_queue_head, memory_order_relaxed);
+    while (true)
+    {
+        __dump_cell_t* cell = &__dump_queue[pos & (LOG_DUMP_QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (seq == pos)
+        {
+            // Cell is free - claim position, then fill and publish it
+            if (atomic_compare_exchange_weak_explicit(&__dump_queue_head, &pos, pos + 1,
+                memory_order_relaxed, memory_order_relaxed))
+            {
+                cell->cmd = *_cmd;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return true;
+            }
+        }
+        // Cell still holds order from previous lap - queue is full
+        else if ((ptrdiff_t)(seq - pos) < 0) { return false; }
+        else { pos = atomic_load_explicit(&__dump_queue_head, memory_order_relaxed); }
+    }
+}
+
+
+bool __dump_queue_pop(__dump_cmd_t* _cmd)
+{
+    __dump_cell_t* cell = &__dump_queue[__dump_queue_tail & (LOG_DUMP_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != __dump_queue_tail + 1)
+    {
+        return false;
+    }
+    *_cmd = cell->cmd;
+    atomic_store_explicit(&cell->seq, __dump_queue_tail + LOG_DUMP_QUEUE_SIZE, memory_order_release);
+    ++__dump_queue_tail;
+    return true;
+}
+
+
+void __dump_stop(void)
+{
+    atomic_store(&__dump_run, false);
+    uint64_t wake = 1;
+    write(__dump_event, &wake, sizeof(wake));
+    pthread_join(__dump_tid, NULL);
+}
+
+
+void* __dump_thread(void* _)
+{
+    __tls_library = true;
+    // Buffer of writer is reused by every DUMP file, so it is registered once
+    __dump_writer = (__dump_writer_t*)malloc(sizeof(__dump_writer_t));
+    if (__io_uring && __dump_writer != NULL && __uring_setup(&__dump_uring) == LOG_RES_SUCCESS)
+    {
+        __uring_register_buffer(&__dump_uring, __dump_writer->data, sizeof(__dump_writer->data));
+        __tls_uring = &__dump_uring;
+    }
+
+    // Windows of rate limit and collapsing close also while their threads do not log
+    int timeout = __rate_interval_ns != 0 || __collapse ? LOG_RATE_SWEEP_MS : -1;
+    uint64_t wakeups;
+    while (atomic_load(&__dump_run))
+    {
+        struct pollfd event = { .fd = __dump_event, .events = POLLIN };
+        int ready = poll(&event, 1, timeout);
+        if (ready < 0 && errno != EINTR) { break; }
+        if (ready > 0 && read(__dump_event, &wakeups, sizeof(wakeups)) < 0 && errno != EINTR) { break; }
+        if (timeout >= 0 && __writer_enter())
+        {
+            __rate_flush(NULL, true);
+            __writer_leave();
+        }
+
+        __dump_cmd_t cmd;
+        while (atomic_load(&__dump_run) && __dump_queue_pop(&cmd))
+        {
+            // Orders of same kind received from now on are handled again
+            atomic_fetch_and(&__dump_pending, ~(1ull << cmd.kind));
+            unsigned coalesced = atomic_exchange(&__dump_coalesced[cmd.kind], 0);
+            if (cmd.kind == LOG_STATS_KIND) { __stats_create(&cmd, coalesced); }
+            else if (cmd.kind == LOG_CONTROL_KIND) { __control_report(&cmd, coalesced); }
+            else { __dump_create(&cmd, coalesced); }
+        }
+    }
+    __uring_teardown(&__dump_uring);
+    free(__dump_writer);
+    __dump_writer = NULL;
+    return NULL;
+}
+
+
+void __log_action(int _signal, siginfo_t* _info, void* _)
+{
+    int value = _info->si_value.sival_int;
+    // Plain level changes every category
+    log_category_t cat = LOG_MAX_CATEGORIES;
+    if (value < LOG_LVL_OFF || value > LOG_LVL_MAX)
+    {
+        cat = ((unsigned)value >> LOG_LVL_BITS) - 1;
+        value = (int)(signed char)(value & ((1 << LOG_LVL_BITS) - 1));
+        if (cat >= atomic_load(&__category_count)) { return; }
+    }
+    if (value != LOG_LVL_OFF
+        && value != LOG_LVL_MIN
+        && value != LOG_LVL_STANDARD
+        && value != LOG_LVL_MAX)
+    {
+        return;
+    }
+    __log_set_level(cat, value);
+}
+
+
+void __dump_action(int _signal, siginfo_t* _info, void* _)
+{
+    int value = _info->si_value.sival_int;
+    int lvl = value & ((1 << LOG_DUMP_LVL_BITS) - 1);
+    unsigned sections = (unsigned)value >> LOG_DUMP_LVL_BITS;
+    if (value < 0
+        || (lvl != LOG_DUMP_LVL_NORMAL
+            && lvl != LOG_DUMP_LVL_DETAIL
+            && lvl != LOG_DUMP_LVL_EXTENDED
+            && lvl != LOG_DUMP_LVL_FULL)
+        || sections > LOG_DUMP_SECTION_ALL)
+    {
+        return;
+    }
+    if (sections == 0) { sections = LOG_DUMP_SECTION_ALL; }
+
+    __dump_cmd_t cmd = {
+        .lvl = (log_dump_lvl_e)lvl,
+        .sections = (log_dump_section_e)sections,
+        .pid = _info->si_pid,
+        .uid = _info->si_uid,
+    };
+    __dump_order((unsigned)lvl * 8 + sections, cmd);
+}
+
+
+void __sync_action(int _signal, siginfo_t* _info, void* _)
+{
+    int value = _info->si_value.sival_int;
+    if (value < 0
+        || __sync_pack(value & ((1 << LOG_SYNC_POLICY_BITS) - 1),
+            (unsigned)value >> LOG_SYNC_POLICY_BITS) != value)
+    {
+        return;
+    }
+    __control->sync = value;
+}
+
+
+void __stats_action(int _signal, siginfo_t* _info, void* _)
+{
+    __dump_cmd_t cmd = {
+        .pid = _info->si_pid,
+        .uid = _info->si_uid,
+    };
+    __dump_order(LOG_STATS_KIND, cmd);
+}
+
+
+__stats_t* __stats_local(void)
+{
+    if (__tls_stats != NULL) { return __tls_stats; }
+    pthread_once(&__stats_once, __stats_key_create);
+
+    // Reuse block of exited thread - its counters keep adding up
+    __stats_t* stats = atomic_load_explicit(&__stats_list, memory_order_acquire);
+    for (; stats != NULL; stats = stats->next)
+    {
+        bool used = false;
+        if (atomic_compare_exchange_strong(&stats->used, &used, true)) { break; }
+    }
+    if (stats == NULL && (stats = (__stats_t*)calloc(1, sizeof(__stats_t))) != NULL)
+    {
+        atomic_init(&stats->used, true);
+        stats->next = atomic_load_explicit(&__stats_list, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&__stats_list, &stats->next, stats,
+            memory_order_release, memory_order_relaxed))
+        {
+        }
+    }
+    if (stats == NULL) { return &__stats_shared; }
+
+    atomic_fetch_add(&__stats_threads, 1);
+    pthread_setspecific(__stats_key, stats);
+    __tls_stats = stats;
+    // Every thread that logs handles its fatal signals on its own stack
+    if (__crash_enabled) { __crash_altstack(); }
+    return stats;
+}
+
+
+void __stats_key_create(void)
+{
+    pthread_key_create(&__stats_key, __stats_exit);
+}
+
+
+void __stats_exit(void* _stats)
+{
+    __stats_t* stats = (__stats_t*)_stats;
+    if (__tls_rate != NULL)
+    {
+        // Once `log_deinit` started, counts are left to it
+        if (__writer_enter())
+        {
+            __rate_state_flush(__tls_rate, NULL, false);
+            __writer_leave();
+        }
+        atomic_store_explicit(&__tls_rate->used, false, memory_order_release);
+        __tls_rate = NULL;
+    }
+    if (__tls_flight != NULL)
+    {
+        atomic_store_explicit(&__tls_flight->used, false, memory_order_release);
+        __tls_flight = NULL;
+    }
+    __tls_stats = NULL;
+    atomic_store_explicit(&stats->used, false, memory_order_release);
+    if (__tls_altstack != NULL)
+    {
+        stack_t altstack = { .ss_flags = SS_DISABLE };
+        sigaltstack(&altstack, NULL);
+        free(__tls_altstack);
+        __tls_altstack = NULL;
+    }
+}
+
+
+void __stats_add(atomic_ullong* _counter, unsigned long long _value)
+{
+    atomic_store_explicit(_counter,
+        atomic_load_explicit(_counter, memory_order_relaxed) + _value, memory_order_relaxed);
+}
+
+
+log_res_e __stats_result(log_res_e _res, size_t _len)
+{
+    __stats_t* stats = __stats_local();
+    switch (_res)
+    {
+    case LOG_RES_SUCCESS:
+        __stats_add(&stats->accepted, 1);
+        __stats_add(&stats->bytes, _len);
+        break;
+    case LOG_RES_IGNORED:
+    case LOG_RES_OFF:
+        __stats_add(&stats->ignored, 1);
+        break;
+    case LOG_RES_DROPPED:
+        __stats_add(&stats->dropped, 1);
+        break;
+    case LOG_RES_SUPPRESSED:
+        __stats_add(&stats->suppressed, 1);
+        break;
+    default:
+        __stats_add(&stats->failed, 1);
+        break;
+    }
+    return _res;
+}
+
+
+unsigned long long __stats_lap(struct timespec* _since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ns = (now.tv_sec - _since->tv_sec) * 1000000000LL + (now.tv_nsec - _since->tv_nsec);
+    *_since = now;
+    return ns > 0 ? (unsigned long long)ns : 0;
+}
+
+
+void __stats_record(__stats_hist_t* _hist, unsigned long long _ns)
+{
+    unsigned bucket = _ns > 1 ? 63 - (unsigned)__builtin_clzll(_ns) : 0;
+    if (bucket >= LOG_STATS_BUCKETS) { bucket = LOG_STATS_BUCKETS - 1; }
+    __stats_add(&_hist->count[bucket], 1);
+    __stats_add(&_hist->total_ns, _ns);
+}
+
+
+void __stats_hist_sum(log_stats_hist_t* _sum, const __stats_hist_t* _hist)
+{
+    for (size_t i = 0; i < LOG_STATS_BUCKETS; ++i)
+    {
+        _sum->count[i] += atomic_load_explicit(&_hist->count[i], memory_order_relaxed);
+    }
+    _sum->total_ns += atomic_load_explicit(&_hist->total_ns, memory_order_relaxed);
+}
+
+
+void __stats_hist_print(__dump_writer_t* _writer, const char* _name, const log_stats_hist_t* _hist)
+{
+    static const unsigned permille[] = { 500, 990, 999, 1000 };
+    static const char* names[] = { "p50", "p99", "p99.9", "max" };
+    unsigned long long total = 0;
+    for (size_t i = 0; i < LOG_STATS_BUCKETS; ++i) { total += _hist->count[i]; }
+    __dump_printf(_writer, "\n%-9s count %llu, total %llu", _name, total, _hist->total_ns);
+    if (total == 0)
+    {
+        __dump_put(_writer, "\n", 1);
+        return;
+    }
+
+    // Percentile is reported as upper bound of bucket it falls into
+    unsigned long long seen = 0;
+    size_t bucket = 0;
+    for (size_t p = 0; p < sizeof(permille) / sizeof(permille[0]); ++p)
+    {
+        unsigned long long rank = (total * permille[p] + 999) / 1000;
+        while (seen + _hist->count[bucket] < rank) { seen += _hist->count[bucket++]; }
+        __dump_printf(_writer, ", %s < %llu", names[p], 2ULL << bucket);
+    }
+    __dump_put(_writer, "\n", 1);
+    for (size_t i = 0; i < LOG_STATS_BUCKETS; ++i)
+    {
+        if (_hist->count[i] == 0) { continue; }
+        __dump_printf(_writer, "    [%llu, %llu%s %llu\n", i ? 1ULL << i : 0ULL, 2ULL << i,
+            i + 1 < LOG_STATS_BUCKETS ? ")" : "+)", _hist->count[i]);
+    }
+}
+
+
+void __control_action(int _signal, siginfo_t* _info, void* _)
+{
+    __dump_cmd_t cmd = {
+        .pid = _info->si_pid,
+        .uid = _info->si_uid,
+    };
+    __dump_order(LOG_CONTROL_KIND, cmd);
+}
+
+
+void __control_share(void)
+{
+    snprintf(__control_name, sizeof(__control_name), LOG_CONTROL_NAME, (intmax_t)getpid());
+    int fd = shm_open(__control_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    // Left behind by crashed process of same PID
+    if (fd < 0 && errno == EEXIST && shm_unlink(__control_name) == 0)
+    {
+        fd = shm_open(__control_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0) { return; }
+    if (ftruncate(fd, sizeof(__control_t)) != 0)
+    {
+        close(fd);
+        shm_unlink(__control_name);
+        return;
+    }
+
+    // Mapping of previous initialization is replaced in place
+    void* addr = mmap(__control_shared, sizeof(__control_t), PROT_READ | PROT_WRITE,
+        MAP_SHARED | (__control_shared != NULL ? MAP_FIXED : 0), fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        shm_unlink(__control_name);
+        return;
+    }
+    __control_shared = (__control_t*)addr;
+
+    memcpy(__control_shared, &__control_local, sizeof(__control_t));
+    __control_shared->version = LOG_CONTROL_VERSION;
+    atomic_store(&__control_shared->generation, 0);
+    // Magic marks block as filled for `log_control_open`
+    atomic_thread_fence(memory_order_release);
+    memcpy(__control_shared->magic, LOG_CONTROL_MAGIC, sizeof(__control_shared->magic));
+
+    __log_enabled = __control_shared->enabled;
+    __control = __control_shared;
+}
+
+
+void __control_unshare(void)
+{
+    if (__control == &__control_local) { return; }
+
+    memcpy(&__control_local, __control_shared, sizeof(__control_t));
+    __log_enabled = __control_local.enabled;
+    __control = &__control_local;
+    shm_unlink(__control_name);
+}
+
+
+void __control_report(const __dump_cmd_t* _cmd, unsigned _coalesced)
+{
+    log_printf(LOG_LVL_MIN, "Control block changed by PID %" PRIdMAX " (UID %" PRIdMAX
+        ") - change #%u, merged with %u later notifications",
+        (intmax_t)_cmd->pid, (intmax_t)_cmd->uid,
+        atomic_load(&__control->generation), _coalesced);
+}
+
+
+log_res_e __tail_start(unsigned _records)
+{
+    uint64_t slots = LOG_TAIL_MIN_RECORDS;
+    while (slots < _records) { slots <<= 1; }
+    size_t size = sizeof(__tail_head_t) + slots * LOG_TAIL_SLOT_SIZE;
+
+    // Ring of previous initialization is no longer published to
+    if (__tail_mapped != NULL)
+    {
+        munmap(__tail_mapped, __tail_mapped_size);
+        __tail_mapped = NULL;
+    }
+
+    __tail_owner = getpid();
+    snprintf(__tail_name, sizeof(__tail_name), LOG_TAIL_NAME, (intmax_t)__tail_owner);
+    int fd = shm_open(__tail_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    // Left behind by crashed process of same PID
+    if (fd < 0 && errno == EEXIST && shm_unlink(__tail_name) == 0)
+    {
+        fd = shm_open(__tail_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0) { return LOG_RES_ERROR_FILE; }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(__tail_name);
+        return LOG_RES_ERROR_FILE;
+    }
+    __tail_head_t* head = (__tail_head_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (head == MAP_FAILED)
+    {
+        shm_unlink(__tail_name);
+        return LOG_RES_ERROR_FILE;
+    }
+
+    // Fresh shared memory is zero-filled - every slot waits for its first lap
+    head->version = LOG_TAIL_VERSION;
+    head->slot_size = LOG_TAIL_SLOT_SIZE;
+    head->slots = slots;
+    atomic_init(&head->dropped, 0);
+    atomic_init(&head->head, 0);
+    // Magic marks ring as filled for `log_tail_open`
+    atomic_thread_fence(memory_order_release);
+    memcpy(head->magic, LOG_TAIL_MAGIC, sizeof(head->magic));
+
+    __tail_mapped = head;
+    __tail_mapped_size = size;
+    __tail = head;
+    return LOG_RES_SUCCESS;
+}
+
+
+void __tail_stop(void)
+{
+    if (__tail == NULL) { return; }
+
+    __tail = NULL;
+    if (__tail_owner == getpid()) { shm_unlink(__tail_name); }
+}
+
+
+__tail_slot_t* __tail_slot(const __tail_head_t* _head, uint64_t _pos)
+{
+    return (__tail_slot_t*)((char*)(_head + 1) + (_pos & (_head->slots - 1)) * LOG_TAIL_SLOT_SIZE);
+}
+
+
+void __tail_publish(const char* _record, size_t _len)
+{
+    __tail_head_t* head = __tail;
+    uint64_t pos = atomic_fetch_add_explicit(&head->head, 1, memory_order_relaxed);
+    __tail_slot_t* slot = __tail_slot(head, pos);
+
+    // Claim slot - give up if writer lapped by ring is still there
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    do
+    {
+        if ((seq & 1) || seq >= 2 * pos + 1)
+        {
+            atomic_fetch_add_explicit(&head->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&slot->seq, &seq, 2 * pos + 1,
+        memory_order_relaxed, memory_order_relaxed));
+    // Readers must see slot as being written before any of its data changes
+    atomic_thread_fence(memory_order_release);
+
+    size_t len = _len < sizeof(slot->data) ? _len : sizeof(slot->data);
+    memcpy(slot->data, _record, len);
+    slot->len = (uint32_t)len;
+    atomic_store_explicit(&slot->seq, 2 * pos + 2, memory_order_release);
+}
+
+
+void __signal_set(sigset_t* _set)
+{
+    sigemptyset(_set);
+    sigaddset(_set, SIGLOG);
+    sigaddset(_set, SIGDUMP);
+    sigaddset(_set, SIGSYNC);
+    sigaddset(_set, SIGSTAT);
+    sigaddset(_set, SIGCTL);
+}
+
+
+log_res_e __signal_start(void)
+{
+    sigset_t sset;
+    __signal_set(&sset);
+    if ((__signal_fd = signalfd(-1, &sset, SFD_NONBLOCK | SFD_CLOEXEC)) < 0) { return LOG_RES_ERROR_SYNC; }
+    if ((__signal_event = eventfd(0, EFD_CLOEXEC)) < 0)
+    {
+        __errno = errno;
+        close(__signal_fd);
+        errno = __errno;
+        return LOG_RES_ERROR_SYNC;
+    }
+    struct epoll_event signal_ev = { .events = EPOLLIN, .data.fd = __signal_fd };
+    struct epoll_event stop_ev = { .events = EPOLLIN, .data.fd = __signal_event };
+    if ((__signal_epoll = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || epoll_ctl(__signal_epoll, EPOLL_CTL_ADD, __signal_fd, &signal_ev) != 0
+        || epoll_ctl(__signal_epoll, EPOLL_CTL_ADD, __signal_event, &stop_ev) != 0)
+    {
+        __errno = errno;
+        if (__signal_epoll >= 0) { close(__signal_epoll); }
+        close(__signal_event);
+        close(__signal_fd);
+        errno = __errno;
+        return LOG_RES_ERROR_SYNC;
+    }
+
+    if ((__errno = pthread_create(&__signal_tid, NULL, __signal_thread, NULL)) != 0)
+    {
+        close(__signal_epoll);
+        close(__signal_event);
+        close(__signal_fd);
+        errno = __errno;
+        return LOG_RES_ERROR_PTHREAD;
+    }
+    return LOG_RES_SUCCESS;
+}
+
+
+void __signal_stop(void)
+{
+    uint64_t wake = 1;
+    write(__signal_event, &wake, sizeof(wake));
+    pthread_join(__signal_tid, NULL);
+    close(__signal_epoll);
+    close(__signal_event);
+    close(__signal_fd);
+}
+
+
+void* __signal_thread(void* _)
+{
+    __tls_library = true;
+    struct epoll_event events[2];
+    struct signalfd_siginfo infos[16];
+    while (true)
+    {
+        int ready = epoll_wait(__signal_epoll, events, 2, -1);
+        if (ready < 0 && errno != EINTR) { break; }
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.fd == __signal_event) { return NULL; }
+        }
+
+        ssize_t got;
+        while ((got = read(__signal_fd, infos, sizeof(infos))) > 0)
+        {
+            for (size_t i = 0; i < (size_t)got / sizeof(infos[0]); ++i) { __signal_dispatch(&infos[i]); }
+        }
+    }
+    return NULL;
+}
+
+
+void __signal_dispatch(const struct signalfd_siginfo* _info)
+{
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.si_signo = (int)_info->ssi_signo;
+    info.si_code = _info->ssi_code;
+    info.si_pid = (pid_t)_info->ssi_pid;
+    info.si_uid = (uid_t)_info->ssi_uid;
+    info.si_value.sival_int = _info->ssi_int;
+
+    int signal = (int)_info->ssi_signo;
+    if (signal == SIGLOG)
+    {
+        __log_action(signal, &info, NULL);
+        log_printf(LOG_LVL_MIN, "LOG level changed by PID %" PRIdMAX " (payload %d)",
+            (intmax_t)info.si_pid, _info->ssi_int);
+    }
+    else if (signal == SIGDUMP) { __dump_action(signal, &info, NULL); }
+    else if (signal == SIGSYNC)
+    {
+        __sync_action(signal, &info, NULL);
+        log_printf(LOG_LVL_MIN, "Durability policy changed by PID %" PRIdMAX " (payload %d)",
+            (intmax_t)info.si_pid, _info->ssi_int);
+    }
+    else if (signal == SIGSTAT) { __stats_action(signal, &info, NULL); }
+    else if (signal == SIGCTL) { __control_action(signal, &info, NULL); }
+}
+
+
+log_res_e __dump_start(void)
+{
+    for (size_t i = 0; i < LOG_DUMP_QUEUE_SIZE; ++i) { atomic_init(&__dump_queue[i].seq, i); }
+    atomic_init(&__dump_queue_head, 0);
+    __dump_queue_tail = 0;
+    atomic_init(&__dump_pending, 0);
+    for (size_t i = 0; i < LOG_DUMP_KINDS; ++i) { atomic_init(&__dump_coalesced[i], 0); }
+    atomic_init(&__dump_seq, 0);
+    atomic_init(&__dump_run, true);
+    if ((__dump_event = eventfd(0, EFD_CLOEXEC)) < 0) { return LOG_RES_ERROR_SYNC; }
+
+    if ((__errno = pthread_create(&__dump_tid, NULL, __dump_thread, NULL)) != 0)
+    {
+        close(__dump_event);
+        errno = __errno;
+        return LOG_RES_ERROR_PTHREAD;
+    }
+    return LOG_RES_SUCCESS;
+}
+
+
+void __fork_register(void)
+{
+    pthread_atfork(__fork_prepare, __fork_parent, __fork_child);
+}
+
+
+void __fork_prepare(void)
+{
+    // Every mutex of library is held, so that none is held by thread that does not survive fork.
+    // Lock order of library: `__init_mux`, `__category_mux`, `__instances_mux`, `mux` of instance,
+    // `__write_mux`, `__rotate_mux`, `__mmap_mux`, `__dump_providers_mux` - `__instances_mux`
+    // is never held while writing
+    pthread_mutex_lock(&__init_mux);
+    pthread_mutex_lock(&__category_mux);
+    pthread_mutex_lock(&__instances_mux);
+    for (log_t* log = __instances; log != NULL; log = log->next) { pthread_mutex_lock(&log->mux); }
+    pthread_mutex_lock(&__write_mux);
+    pthread_mutex_lock(&__rotate_mux);
+    pthread_mutex_lock(&__mmap_mux);
+    pthread_mutex_lock(&__dump_providers_mux);
+}
+
+
+void __fork_parent(void)
+{
+    pthread_mutex_unlock(&__dump_providers_mux);
+    pthread_mutex_unlock(&__mmap_mux);
+    pthread_mutex_unlock(&__rotate_mux);
+    pthread_mutex_unlock(&__write_mux);
+    for (log_t* log = __instances; log != NULL; log = log->next) { pthread_mutex_unlock(&log->mux); }
+    pthread_mutex_unlock(&__instances_mux);
+    pthread_mutex_unlock(&__category_mux);
+    pthread_mutex_unlock(&__init_mux);
+}
+
+
+void __fork_child(void)
+{
+    // Forking thread holds mutexes of `__fork_prepare` in child too - condition variable
+    // has no waiter left, since rotation thread did not survive fork
+    __fork_parent();
+    pthread_cond_init(&__rotate_cond, NULL);
+    __tls_tid = 0;
+    // Writer sections of threads that did not survive fork are never left
+    atomic_store(&__writers_inflight, 0);
+    atomic_store(&__crash_reclaimer, 0);
+
+    // Unless shared, instances of child start their own LOG files - instance,
+    // that cannot, keeps appending to LOG file of parent
+    for (log_t* log = __instances; log != NULL; log = log->next)
+    {
+        // Pins of threads that did not survive fork are never released
+        atomic_store(&log->pins, 0);
+        if (__shared) { continue; }
+        int fd = __instance_open_file(log);
+        if (fd < 0) { continue; }
+        close(log->fd);
+        log->fd = fd;
+        log->sync_pending = 0;
+    }
+
+    // Counters of child start from zero - only block of forking thread stays in use
+    for (__stats_t* stats = atomic_load(&__stats_list); stats != NULL; stats = stats->next)
+    {
+        memset((char*)stats + offsetof(__stats_t, accepted), 0,
+            sizeof(__stats_t) - offsetof(__stats_t, accepted));
+        if (stats != __tls_stats && stats != &__stats_shared) { atomic_store(&stats->used, false); }
+    }
+    atomic_store(&__stats_threads, __tls_stats != NULL ? 1 : 0);
+    // Rings of threads that did not survive fork keep their messages until reused
+    for (__flight_t* flight = atomic_load(&__flight_list); flight != NULL; flight = flight->next)
+    {
+        if (flight != __tls_flight) { atomic_store(&flight->used, false); }
+    }
+    // Counts of threads that did not survive fork are reported by parent
+    for (__rate_state_t* rate = atomic_load(&__rate_list); rate != NULL; rate = rate->next)
+    {
+        if (rate == __tls_rate) { continue; }
+        atomic_store(&rate->used, false);
+        atomic_store(&rate->repeat.repeated, 0);
+        for (size_t i = 0; i < sizeof(rate->slots) / sizeof(rate->slots[0]); ++i)
+        {
+            atomic_store(&rate->slots[i].suppressed, 0);
+        }
+    }
+
+    if (__init_ready == false) { return; }
+    if (__fork_reinit() != LOG_RES_SUCCESS)
+    {
+        __init_ready = false;
+        atomic_store(&__writers_open, false);
+        __log_set_level(LOG_MAX_CATEGORIES, LOG_LVL_OFF);
+        __log_capture = 0;
+        return;
     }
+    // Notice of library does not order flight DUMP
+    bool library = __tls_library;
+    __tls_library = true;
+    log_printf(LOG_LVL_MIN, "Process forked from PID %" PRIdMAX, (intmax_t)getppid());
+    __tls_library = library;
+}
 
-    // Check if `pmap` command is present
-    __pmap_present = (system("pmap -V > /dev/null 2>&1") == 0);
 
-    // Lock LOG file
-    log_res_e ret = __change_file_lock(__log_fd, true);
-    if (ret != LOG_RES_SUCCESS)
+log_res_e __fork_reinit(void)
+{
+    // Control block of parent is left to parent - child starts with copy of it
+    if (__control != &__control_local)
     {
-        __errno = errno;
-        close(__log_fd);
-        errno = __errno;
-        return ret;
+        memcpy(&__control_local, __control, sizeof(__control_t));
+        __log_enabled = __control_local.enabled;
+        __control = &__control_local;
     }
-
-    // Create pipe (used as queue) for DUMP orders
-    if (pipe((int*)&__dump_pipe) != 0)
+    // Chunks of parent's LOG file cannot be shared safely - child drops its copies of mappings
+    // (leaving syncing and truncating to parent), and writes its own LOG file synchronously
+    if (__mode == LOG_MODE_MMAP)
     {
-        __errno = errno;
-        __change_file_lock(__log_fd, false);
-        close(__log_fd);
-        errno = __errno;
-        return LOG_RES_ERROR_SYNC;
+        for (size_t i = 0; i < LOG_MMAP_MAX_CHUNKS; ++i)
+        {
+            char* addr = atomic_exchange(&__mmap_chunks[i].addr, NULL);
+            if (addr != NULL) { munmap(addr, __mmap_chunk); }
+        }
+        __mode = LOG_MODE_SYNC;
+        __sync_pending = 0;
     }
+    __control_share();
 
-    // Launch DUMP thread
-    if ((__errno = pthread_create(&__dump_tid, NULL, __dump_thread, NULL)) != 0)
+    // Threads of parent are gone, and so are their pending DUMP orders and providers,
+    // rings and buffers
+    close(__dump_event);
+    __uring_teardown(&__dump_uring);
+    __uring_teardown(&__flush_uring);
+    free(__dump_writer);
+    __dump_writer = NULL;
+    for (size_t i = 0; i < LOG_DUMP_MAX_PROVIDERS; ++i) { atomic_store(&__dump_providers[i].running, 0); }
+    log_res_e ret = __dump_start();
+    if (ret != LOG_RES_SUCCESS) { return ret; }
+    if (__signals == LOG_SIGNALS_THREAD)
     {
-        __change_file_lock(__log_fd, false);
-        close(__log_fd);
-        close(__dump_pipe.read);
-        close(__dump_pipe.write);
-        errno = __errno;
-        return LOG_RES_ERROR_PTHREAD;
+        close(__signal_epoll);
+        close(__signal_event);
+        close(__signal_fd);
+        if ((ret = __signal_start()) != LOG_RES_SUCCESS) { return ret; }
     }
 
-    // Unlock signals used for communication
-    sigset_t sset;
-    sigemptyset(&sset);
-    sigaddset(&sset, SIGLOG);
-    sigaddset(&sset, SIGDUMP);
-    pthread_sigmask(SIG_UNBLOCK, &sset, NULL);
-
-    // Set signal handlers
-    ret = __register_signal(SIGLOG, __log_action);
-    if (ret != LOG_RES_SUCCESS)
+    // Rotated LOG files queued by parent are compressed by parent
+    __rotate_running = false;
+    __rotate_jobs = NULL;
+    __rotate_jobs_tail = &__rotate_jobs;
+    if (!__shared)
     {
-        __errno = errno;
-        __change_file_lock(__log_fd, false);
         close(__log_fd);
-        close(__dump_pipe.read);
-        close(__dump_pipe.write);
-        pthread_cancel(__dump_tid);
-        errno = __errno;
-        return ret;
+        __log_name_sec = 0;
+        __log_fd = __open_log_file(&__log_base);
+        if (__log_fd < 0) { return LOG_RES_ERROR_FILE; }
+        if ((ret = __change_file_lock(__log_fd, true)) != LOG_RES_SUCCESS) { return ret; }
+        __log_bytes = __log_base;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        __rotate_since = now.tv_sec;
     }
-    ret = __register_signal(SIGDUMP, __dump_action);
-    if (ret != LOG_RES_SUCCESS)
+
+    // Rings hold messages of parent's threads - parent writes them out
+    if (__mode == LOG_MODE_ASYNC)
     {
-        __errno = errno;
-        __change_file_lock(__log_fd, false);
-        close(__log_fd);
-        close(__dump_pipe.read);
-        close(__dump_pipe.write);
-        pthread_cancel(__dump_tid);
-        __register_signal(SIGLOG, NULL);
-        errno = __errno;
-        return ret;
+        pthread_key_delete(__ctx_key);
+        __thread_ctx_t* ctx = atomic_exchange(&__ctx_list, NULL);
+        while (ctx != NULL)
+        {
+            __thread_ctx_t* next = ctx->next;
+            free(ctx->ring.buf);
+            free(ctx);
+            ctx = next;
+        }
+        if ((ret = __flush_start()) != LOG_RES_SUCCESS) { return ret; }
     }
-
-    __init_ready = true;
-    __current_log_lvl = LOG_LVL_MAX;
-    pthread_mutex_unlock(&__init_mux);
     return LOG_RES_SUCCESS;
 }
 
 
-log_res_e log_deinit(void)
+log_res_e __instance_write(log_t* _log, const char* _record, size_t _len)
 {
-    if (EBUSY == pthread_mutex_trylock(&__init_mux)
-        || __init_ready == false)
-    {
-        return LOG_RES_ERROR_DUP;
-    }
-
-    // Remove signal handlers
-    __register_signal(SIGLOG, NULL);
-    __register_signal(SIGDUMP, NULL);
+    __stats_t* stats = __stats_local();
+    struct timespec lap;
+    clock_gettime(CLOCK_MONOTONIC, &lap);
+    if (pthread_mutex_lock(&_log->mux) != 0) { return LOG_RES_ERROR_SYNC; }
+    __stats_record(&stats->lock_wait, __stats_lap(&lap));
 
-    // Cancel DUMP thread
-    pthread_cancel(__dump_tid);
+    struct iovec iov = { .iov_base = (void*)_record, .iov_len = _len };
+    log_res_e ret = __writev_all(_log->fd, &iov, 1);
+    __stats_record(&stats->write, __stats_lap(&lap));
+    __sync_file(_log->fd, _log->sync, &_log->sync_pending, &_log->sync_last, 1);
+    pthread_mutex_unlock(&_log->mux);
 
-    // Unlock LOG file
-    __change_file_lock(__log_fd, false);
+    return ret;
+}
 
-    // Close LOG file
-    close(__log_fd);
 
-    // Close pipe
-    close(__dump_pipe.read);
-    close(__dump_pipe.write);
+int __instance_open_file(const log_t* _log)
+{
+    int fd = -1;
+    for (unsigned seq = 0; fd < 0 && seq < LOG_MAX_NAME_SEQ; ++seq)
+    {
+        char* path = __create_file_name(_log->name, "LOG", seq);
+        fd = open(path, O_CREAT | O_EXCL | O_RDWR | O_APPEND,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_ISGID);
+        __errno = errno;
+        free(path);
+        if (fd < 0 && __errno != EEXIST)
+        {
+            errno = __errno;
+            return -1;
+        }
+    }
+    if (fd < 0) { return -1; }
 
-    __current_log_lvl = LOG_LVL_OFF;
-    __init_ready = false;
-    pthread_mutex_unlock(&__init_mux);
-    return LOG_RES_SUCCESS;
+    if (__change_file_lock(fd, true) != LOG_RES_SUCCESS)
+    {
+        __errno = errno;
+        close(fd);
+        errno = __errno;
+        return -1;
+    }
+    return fd;
 }
 
 
-log_res_e log_printf(log_lvl_e _lvl, const char* _format, ...)
+log_res_e __uring_setup(__uring_t* _ring)
 {
-    if (LOG_LVL_MIN > _lvl || _lvl > LOG_LVL_MAX) { return LOG_RES_ERROR_OTHER; }
-    if (__current_log_lvl == LOG_LVL_OFF)
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, LOG_URING_ENTRIES, &params);
+    if (fd < 0) { return LOG_RES_ERROR_OTHER; }
+
+    // Both rings share single mapping, if kernel allows it
+    _ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
     {
-        return LOG_RES_OFF;
+        if (_ring->cq_ring_size > _ring->sq_ring_size) { _ring->sq_ring_size = _ring->cq_ring_size; }
+        _ring->cq_ring_size = 0;
     }
-    if (__current_log_lvl < _lvl)
+    _ring->sq_ring = mmap(NULL, _ring->sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (_ring->sq_ring == MAP_FAILED)
     {
-        return LOG_RES_IGNORED;
+        close(fd);
+        return LOG_RES_ERROR_OTHER;
     }
-    if (pthread_mutex_lock(&__write_mux) != 0
-        || __init_ready == false)
+    _ring->cq_ring = _ring->sq_ring;
+    if (_ring->cq_ring_size != 0)
     {
-        return LOG_RES_ERROR_DUP;
+        _ring->cq_ring = mmap(NULL, _ring->cq_ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (_ring->cq_ring == MAP_FAILED)
+        {
+            munmap(_ring->sq_ring, _ring->sq_ring_size);
+            close(fd);
+            return LOG_RES_ERROR_OTHER;
+        }
     }
-    
-    char head[29] = { 0 };
-    switch (_lvl)
+    _ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    _ring->sqes = (struct io_uring_sqe*)mmap(NULL, _ring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (_ring->sqes == MAP_FAILED)
     {
-    case LOG_LVL_MIN:
-        sprintf(head, "[MIN @ ");
-        break;
-    case LOG_LVL_STANDARD:
-        sprintf(head, "[STD @ ");
-        break;
-    case LOG_LVL_MAX:
-        sprintf(head, "[MAX @ ");
-        break;
-    default: break;
+        if (_ring->cq_ring_size != 0) { munmap(_ring->cq_ring, _ring->cq_ring_size); }
+        munmap(_ring->sq_ring, _ring->sq_ring_size);
+        close(fd);
+        return LOG_RES_ERROR_OTHER;
     }
-    time_t now = time(NULL);
-    struct tm* now_info = localtime(&now);
-    strftime(head + 7, 22, "%Y-%m-%d|%H:%M:%S] ", now_info);
-    dprintf(__log_fd, "%s", head);
-
-    va_list format_args;
-    va_start(format_args, _format);
-    int ret = vdprintf(__log_fd, _format, format_args);
-    va_end(format_args);
 
-    dprintf(__log_fd, "\n");
-    fsync(__log_fd);
-    pthread_mutex_unlock(&__write_mux);
-    
-    return ret >= 0 ? LOG_RES_SUCCESS : LOG_RES_ERROR_OTHER;
+    char* sq = (char*)_ring->sq_ring;
+    char* cq = (char*)_ring->cq_ring;
+    _ring->sq_head = (atomic_uint*)(sq + params.sq_off.head);
+    _ring->sq_tail = (atomic_uint*)(sq + params.sq_off.tail);
+    _ring->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    _ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    _ring->cq_head = (atomic_uint*)(cq + params.cq_off.head);
+    _ring->cq_tail = (atomic_uint*)(cq + params.cq_off.tail);
+    _ring->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    _ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    _ring->file = -1;
+    _ring->buf = NULL;
+    _ring->buf_size = 0;
+    _ring->fd = fd;
+    return LOG_RES_SUCCESS;
 }
 
 
-log_res_e log_dispatch_log_level(pid_t _pid, log_lvl_e _lvl)
+void __uring_teardown(__uring_t* _ring)
 {
-    pid_t pid;
-    if (_pid == 0) { pid = getpid(); }
-    else { pid = _pid; }
+    if (_ring->fd < 0) { return; }
+    munmap(_ring->sqes, _ring->sqes_size);
+    if (_ring->cq_ring_size != 0) { munmap(_ring->cq_ring, _ring->cq_ring_size); }
+    munmap(_ring->sq_ring, _ring->sq_ring_size);
+    // Closing ring releases registered files and buffers
+    close(_ring->fd);
+    _ring->fd = -1;
+    _ring->file = -1;
+    _ring->buf = NULL;
+}
 
-    if (_lvl != LOG_LVL_OFF
-        && _lvl != LOG_LVL_MIN
-        && _lvl != LOG_LVL_STANDARD
-        && _lvl != LOG_LVL_MAX)
+
+bool __uring_register_file(__uring_t* _ring, int _fd)
+{
+    if (_ring->file == _fd) { return true; }
+    long ret;
+    if (_ring->file < 0)
     {
-        return LOG_RES_ERROR_ARG;
+        ret = syscall(__NR_io_uring_register, _ring->fd, IORING_REGISTER_FILES, &_fd, 1);
     }
-
-    return __dispatch_signal(pid, SIGLOG, _lvl);
+    else
+    {
+        struct io_uring_files_update update = { .offset = 0, .fds = (uintptr_t)&_fd };
+        ret = syscall(__NR_io_uring_register, _ring->fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+        if (ret != 1)
+        {
+            syscall(__NR_io_uring_register, _ring->fd, IORING_UNREGISTER_FILES, NULL, 0);
+            _ring->file = -1;
+            return false;
+        }
+    }
+    if (ret < 0) { return false; }
+    _ring->file = _fd;
+    return true;
 }
 
 
-log_res_e log_dispatch_log_dump(pid_t _pid, log_dump_lvl_e _lvl)
+bool __uring_register_buffer(__uring_t* _ring, const char* _buf, size_t _size)
 {
-    pid_t pid;
-    if (_pid == 0) { pid = getpid(); }
-    else { pid = _pid; }
-
-    if (_lvl != LOG_DUMP_LVL_NORMAL
-        && _lvl != LOG_DUMP_LVL_DETAIL
-        && _lvl != LOG_DUMP_LVL_EXTENDED
-        && _lvl != LOG_DUMP_LVL_FULL)
+    struct iovec iov = { .iov_base = (void*)_buf, .iov_len = _size };
+    if (syscall(__NR_io_uring_register, _ring->fd, IORING_REGISTER_BUFFERS, &iov, 1) != 0)
     {
-        return LOG_RES_ERROR_ARG;
+        return false;
     }
-
-    return __dispatch_signal(pid, SIGDUMP, _lvl);
+    _ring->buf = _buf;
+    _ring->buf_size = _size;
+    return true;
 }
 
 
-//============================================================================//
+log_res_e __uring_write(__uring_t* _ring, int _fd, struct iovec* _iov, int _cnt,
+    bool _sync, bool _data_only)
+{
+    // Only owning thread submits, so tail is never modified concurrently
+    unsigned tail = atomic_load_explicit(_ring->sq_tail, memory_order_relaxed);
+    unsigned count = 0;
+    size_t len = 0;
+    for (int i = 0; i < _cnt; ++i) { len += _iov[i].iov_len; }
+    if (len != 0)
+    {
+        struct io_uring_sqe* sqe = &_ring->sqes[tail & _ring->sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        const char* base = (const char*)_iov[0].iov_base;
+        if (_cnt == 1 && _ring->buf != NULL
+            && base >= _ring->buf && base + len <= _ring->buf + _ring->buf_size)
+        {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = (uintptr_t)base;
+            sqe->len = (unsigned)len;
+            sqe->buf_index = 0;
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = (uintptr_t)_iov;
+            sqe->len = (unsigned)_cnt;
+        }
+        sqe->fd = _fd;
+        if (_fd == _ring->file)
+        {
+            sqe->fd = 0;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        // Current file offset (-1) - LOG file is opened with `O_APPEND` anyway
+        sqe->off = (uint64_t)-1;
+        sqe->user_data = 1;
+        if (_sync) { sqe->flags |= IOSQE_IO_LINK; }
+        _ring->sq_array[tail & _ring->sq_mask] = tail & _ring->sq_mask;
+        ++tail;
+        ++count;
+    }
+    if (_sync)
+    {
+        struct io_uring_sqe* sqe = &_ring->sqes[tail & _ring->sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = _fd;
+        if (_fd == _ring->file)
+        {
+            sqe->fd = 0;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        sqe->fsync_flags = _data_only ? IORING_FSYNC_DATASYNC : 0;
+        sqe->user_data = 2;
+        _ring->sq_array[tail & _ring->sq_mask] = tail & _ring->sq_mask;
+        ++tail;
+        ++count;
+    }
+    if (count == 0) { return LOG_RES_SUCCESS; }
+    atomic_store_explicit(_ring->sq_tail, tail, memory_order_release);
 
+    // Submit and wait for all completions with single call - repeated only if interrupted
+    long submitted = syscall(__NR_io_uring_enter, _ring->fd, count, count, IORING_ENTER_GETEVENTS,
+        NULL, 0);
+    if (submitted < 0 && errno != EINTR)
+    {
+        // Entries were not consumed - withdraw them
+        atomic_store_explicit(_ring->sq_tail, tail - count, memory_order_release);
+        return LOG_RES_ERROR_OTHER;
+    }
 
-char* __create_file_name(const char* _extension)
-{
-    const size_t path_max_len =
-        __path_len + 1 // "${_path }/"
-        + 3 + sizeof(intmax_t) * 8 + 1 // "pid${ PID }_"
-        + 20 + 1 + strlen(_extension) // "${YYYY-MM-DD-HH.mm.ss}.${extension}"
-        + 1 // null-string-terminator
-        ;
-    size_t path_len = __path_len;
+    long written = 0;
+    int sync_res = 0;
+    unsigned head = atomic_load_explicit(_ring->cq_head, memory_order_relaxed);
+    for (unsigned reaped = 0; reaped < count;)
+    {
+        if (head == atomic_load_explicit(_ring->cq_tail, memory_order_acquire))
+        {
+            // (entries not consumed by interrupted call are submitted again)
+            unsigned unsubmitted = tail - atomic_load_explicit(_ring->sq_head, memory_order_acquire);
+            syscall(__NR_io_uring_enter, _ring->fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            continue;
+        }
+        const struct io_uring_cqe* cqe = &_ring->cqes[head & _ring->cq_mask];
+        if (cqe->user_data == 1) { written = cqe->res; }
+        else { sync_res = cqe->res; }
+        ++head;
+        ++reaped;
+        atomic_store_explicit(_ring->cq_head, head, memory_order_release);
+    }
 
-    char* path = (char*)calloc(path_max_len, sizeof(char));
+    if (written < 0) { return LOG_RES_ERROR_OTHER; }
+    if ((size_t)written < len)
+    {
+        // Rest of short write, and sync cancelled by it, are done directly
+        while (_cnt > 0 && (size_t)written >= _iov->iov_len)
+        {
+            written -= _iov->iov_len;
+            ++_iov;
+            --_cnt;
+        }
+        _iov->iov_base = (char*)_iov->iov_base + written;
+        _iov->iov_len -= written;
+        if (__writev_all(_fd, _iov, _cnt) != LOG_RES_SUCCESS) { return LOG_RES_ERROR_FILE; }
+        sync_res = -ECANCELED;
+    }
+    if (_sync && sync_res == -ECANCELED)
+    {
+        if (_data_only) { fdatasync(_fd); }
+        else { fsync(_fd); }
+    }
+    return LOG_RES_SUCCESS;
+}
 
-    strncpy(path, __path, path_len);
-    path[path_len] = '/';
-    sprintf(path + path_len + 1, "pid%" PRIdMAX "_", (intmax_t)getpid());
-    path_len = strlen(path);
-    time_t now = time(NULL);
-    struct tm* now_info = localtime(&now);
-    strftime(path + path_len, 21, "%Y-%m-%d-%H.%M.%S.", now_info);
-    path_len = strlen(path);
-    strncpy(path + path_len, _extension, 8);
 
-    return path;
+bool __flush_submit(struct iovec* _iov, int _cnt, bool _last, size_t _messages)
+{
+    // LOG file changes on rotation
+    if (__flush_uring.file != __log_fd) { __uring_register_file(&__flush_uring, __log_fd); }
+
+    bool data_only = false;
+    bool sync = _last && __sync_due(__control->sync, &__sync_pending, &__sync_last,
+        _messages, &data_only);
+    log_res_e ret = __uring_write(&__flush_uring, __log_fd, _iov, _cnt, sync, data_only);
+    if (ret == LOG_RES_ERROR_OTHER)
+    {
+        __uring_teardown(&__flush_uring);
+        __writev_all(__log_fd, _iov, _cnt);
+        if (sync && data_only) { fdatasync(__log_fd); }
+        else if (sync) { fsync(__log_fd); }
+    }
+    return _last;
 }
- 
 
-log_res_e __change_file_lock(int _fd, bool _lock)
+
+void __crash_start(void)
 {
-    short type;
-    if (_lock == 1) { type = F_WRLCK; }
-    else { type = F_UNLCK; }
+    // Offset is read once - change of DST while running is not reflected in crash record
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    __crash_gmtoff = tm.tm_gmtoff;
+    // First call of `backtrace` loads unwinder, which allocates - not possible in handler
+    void* frames[1];
+    backtrace(frames, 1);
+    __crash_altstack();
 
-    struct flock log_lock = {
-        .l_type = type,
-        .l_whence = SEEK_SET,
-        .l_start = 0,
-        .l_len = 0,
-        .l_pid = getpid()
+    sigset_t all;
+    sigfillset(&all);
+    struct sigaction action_config = {
+        .sa_sigaction = __crash_action,
+        .sa_mask = all,
+        .sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND,
     };
-    if (fcntl(_fd, F_SETLK, &log_lock) < 0) { return LOG_RES_ERROR_SYNC; };
-    return LOG_RES_SUCCESS;
+    for (size_t i = 0; i < LOG_CRASH_SIGNALS; ++i)
+    {
+        sigaction(__crash_signals[i], &action_config, &__crash_old[i]);
+    }
 }
 
 
-log_res_e __dispatch_signal(pid_t _pid, int _signal, int _value)
+void __crash_stop(void)
 {
-    union sigval value = { .sival_int = _value };
-    if (sigqueue(_pid, _signal, value) != 0) { return LOG_RES_ERROR_SYNC; }
-    return LOG_RES_SUCCESS;
+    for (size_t i = 0; i < LOG_CRASH_SIGNALS; ++i)
+    {
+        sigaction(__crash_signals[i], &__crash_old[i], NULL);
+    }
 }
 
 
-log_res_e __register_signal(int _signal, void (*_action) (int, siginfo_t*, void*))
+void __crash_altstack(void)
 {
-    sigset_t all;
-    if (_action != NULL)
-    {
-        sigfillset(&all);
+    if (__tls_altstack != NULL) { return; }
+    // Thread may have alternate stack of its own
+    stack_t altstack;
+    if (sigaltstack(NULL, &altstack) != 0 || (altstack.ss_flags & SS_DISABLE) == 0) { return; }
 
-        struct sigaction action_config = {
-            .sa_sigaction = _action,
-            .sa_mask = all,
-            .sa_flags = SA_SIGINFO,
-        };
-        if (sigaction(_signal, &action_config, NULL) != 0) { return LOG_RES_ERROR_SYNC; }
-    }
-    else
+    altstack.ss_sp = malloc(LOG_CRASH_STACK_SIZE);
+    if (altstack.ss_sp == NULL) { return; }
+    altstack.ss_size = LOG_CRASH_STACK_SIZE;
+    altstack.ss_flags = 0;
+    if (sigaltstack(&altstack, NULL) != 0)
     {
-        sigemptyset(&all);
-
-        struct sigaction action_config = {
-            .sa_handler = SIG_DFL,
-            .sa_mask = all,
-            .sa_flags = 0,
-        };
-        if (sigaction(_signal, &action_config, NULL) != 0) { return LOG_RES_ERROR_SYNC; }
+        free(altstack.ss_sp);
+        return;
     }
-    return LOG_RES_SUCCESS;
+    __tls_altstack = altstack.ss_sp;
 }
 
 
-void* __dump_thread(void* _)
+void __crash_action(int _signal, siginfo_t* _info, void* _)
 {
-    char buf;
-    int ret;
-    while (read(__dump_pipe.read, &buf, 1) > 0)
+    // Fatal signal of other thread waits, until process is killed by first one
+    if (atomic_exchange(&__crash_active, true))
     {
-        char* dump_path = __create_file_name("DUMP");
-        char* command;
-        if (__pmap_present)
-        {
-            command = (char*)calloc(
-                9 // "pmap " + 3 max for args + " "
-                + sizeof(intmax_t) * 8 // PID
-                + 3 // " > "
-                + strlen(dump_path),
-                sizeof(char)
-            );
-            sprintf(command, "pmap     %" PRIdMAX " > %s", (intmax_t)getpid(), dump_path);
-            free(dump_path);
-            switch (buf)
-            {
-            case LOG_DUMP_LVL_NORMAL:
-                strncpy(command + 5, "", 0);
-                break;
-            case LOG_DUMP_LVL_DETAIL:
-                strncpy(command + 5, "-x", 2);
-                break;
-            case LOG_DUMP_LVL_EXTENDED:
-                strncpy(command + 5, "-X", 2);
-                break;
-            case LOG_DUMP_LVL_FULL:
-                strncpy(command + 5, "-XX", 3);
-                break;
-            default:
-                free(command);
-                log_printf(LOG_LVL_MIN, "Failed to create DUMP file using `pmap`: invalid DUMP_LVL [%d]", (int)buf);
-                continue;
-            }
-            
-            if ((ret = system(command)) != 0)
-            {
-                log_printf(LOG_LVL_MIN, "Failed to create DUMP file using `pmap`: command returned code [%d]", ret);
-            }
-            else
-            {
-                log_printf(LOG_LVL_MIN, "Created DUMP file using command: `%*s`", 8, command);
-            }
-        }
-        else
-        {
-            command = (char*)calloc(
-                10 // "cat /proc/"
-                + sizeof(intmax_t) * 8 // PID
-                + 8 // "/maps > "
-                + strlen(dump_path),
-                sizeof(char)
-            );
-            sprintf(command, "cat /proc/%" PRIdMAX "/maps > %s", (intmax_t)getpid(), dump_path);
-            free(dump_path);
+        while (true) { pause(); }
+    }
+
+    const char* signal_name = "?";
+    for (size_t i = 0; i < LOG_CRASH_SIGNALS; ++i)
+    {
+        if (__crash_signals[i] == _signal) { signal_name = __crash_names[i]; }
+    }
+
+    if (__init_ready)
+    {
+        if (__mode == LOG_MODE_ASYNC) { __crash_flush(); }
+        char dump_path[PATH_MAX];
+        bool dumped = __crash_dump(signal_name, _info, dump_path);
 
-            if ((ret = system(command)) != 0)
+        if (__format == LOG_FORMAT_TEXT && __mode != LOG_MODE_MMAP)
+        {
+            // `[MIN @ timestamp] Fatal signal ...` - rendered without `printf`
+            char record[PATH_MAX + 256];
+            memcpy(record, __lvl_tags[LOG_LVL_MIN], 7);
+            size_t len = 7;
+            struct timespec now;
+            __read_clock(&now);
+            if (__ts_mode != LOG_TS_MONOTONIC && __tls_ts.sec != now.tv_sec)
             {
-                log_printf(LOG_LVL_MIN, "Failed to create DUMP file using `cat /proc/[PID]/maps`: command returned code [%d]", ret);
+                __crash_tm(now.tv_sec, &__tls_ts.tm);
+                __put_tm(__tls_ts.text, &__tls_ts.tm, '|', ':');
+                __tls_ts.sec = now.tv_sec;
             }
-            else
+            len += __render_timestamp(record + len, &now, __ts_mode);
+            len += __put_str(record + len, "] Fatal signal ");
+            len += __put_str(record + len, signal_name);
+            len += __put_str(record + len, " (");
+            len += __put_uint(record + len, (unsigned long long)_signal);
+            len += __put_str(record + len, ") in thread ");
+            len += __put_uint(record + len, (unsigned long long)syscall(SYS_gettid));
+            if (dumped)
             {
-                log_printf(LOG_LVL_MIN, "Created DUMP file using command: `cat /proc/[PID]/maps`");
+                len += __put_str(record + len, ", crash DUMP file [");
+                len += __put_str(record + len, dump_path);
+                len += __put_str(record + len, "]\n");
             }
+            else { len += __put_str(record + len, ", crash DUMP file not created\n"); }
+            struct iovec iov = { .iov_base = record, .iov_len = len };
+            __writev_all(__log_fd, &iov, 1);
         }
-        free(command);
+        fsync(__log_fd);
+        for (log_t* log = __instances; log != NULL; log = log->next) { fsync(log->fd); }
     }
-    return NULL;
+
+    // Action was reset to default on entry - signal is delivered again once handler returns
+    // (fault repeats anyway)
+    raise(_signal);
 }
 
 
-void __log_action(int _signal, siginfo_t* _info, void* _)
+void __crash_flush(void)
 {
-    int value = _info->si_value.sival_int;
-    if (value != LOG_LVL_OFF
-        && value != LOG_LVL_MIN
-        && value != LOG_LVL_STANDARD
-        && value != LOG_LVL_MAX)
+    // State being freed by flusher thread is unlinked first - unless it is this thread,
+    // which does not return to finish it
+    pid_t self = (pid_t)syscall(SYS_gettid);
+    pid_t reclaimer;
+    while ((reclaimer = atomic_load(&__crash_reclaimer)) != 0 && reclaimer != self) { }
+
+    // Flusher thread may be writing same messages - duplicate is better than loss
+    __thread_ctx_t* ctx = atomic_load_explicit(&__ctx_list, memory_order_acquire);
+    for (; ctx != NULL; ctx = ctx->next)
     {
-        return;
+        size_t head = atomic_load_explicit(&ctx->ring.head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ctx->ring.tail, memory_order_acquire);
+        if (head == tail) { continue; }
+
+        struct iovec iov[2];
+        size_t size = ctx->ring.mask + 1;
+        size_t at = tail & ctx->ring.mask;
+        size_t len = head - tail;
+        size_t first = size - at < len ? size - at : len;
+        iov[0] = (struct iovec){ .iov_base = ctx->ring.buf + at, .iov_len = first };
+        iov[1] = (struct iovec){ .iov_base = ctx->ring.buf, .iov_len = len - first };
+        __writev_all(__log_fd, iov, first < len ? 2 : 1);
+        atomic_store_explicit(&ctx->ring.tail, head, memory_order_release);
     }
-    __current_log_lvl = value;
 }
 
 
-void __dump_action(int _signal, siginfo_t* _info, void* _)
+bool __crash_dump(const char* _signal_name, const siginfo_t* _info, char* _path)
 {
-    int value = _info->si_value.sival_int;
-    if (value != LOG_DUMP_LVL_NORMAL
-        && value != LOG_DUMP_LVL_DETAIL
-        && value != LOG_DUMP_LVL_EXTENDED
-        && value != LOG_DUMP_LVL_FULL)
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    struct tm tm;
+    __crash_tm(now.tv_sec, &tm);
+    int fd = -1;
+    for (unsigned seq = 0; fd < 0 && seq < LOG_MAX_NAME_SEQ; ++seq)
     {
-        return;
+        if (__path_len + 64 + 24 >= PATH_MAX) { return false; }
+        __render_file_name(_path, NULL, "DUMP", seq, &tm);
+        fd = open(_path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd < 0 && errno != EEXIST) { return false; }
+    }
+    if (fd < 0) { return false; }
+
+    // `PID:   # CRASH DUMP - SIGNAL (N) at address 0x...`
+    char line[128];
+    size_t len = __put_uint(line, (unsigned long long)getpid());
+    len += __put_str(line + len, ":   # CRASH DUMP - ");
+    len += __put_str(line + len, _signal_name);
+    len += __put_str(line + len, " (");
+    len += __put_uint(line + len, (unsigned long long)_info->si_signo);
+    len += __put_str(line + len, ") at address 0x");
+    uintptr_t addr = (uintptr_t)_info->si_addr;
+    for (int shift = (int)sizeof(addr) * 8 - 4; shift >= 0; shift -= 4)
+    {
+        line[len++] = "0123456789abcdef"[(addr >> shift) & 0xF];
+    }
+    len += __put_str(line + len, "\n\n# Backtrace\n");
+    struct iovec iov = { .iov_base = line, .iov_len = len };
+    __writev_all(fd, &iov, 1);
+
+    void* frames[LOG_CRASH_FRAMES];
+    int frames_cnt = backtrace(frames, LOG_CRASH_FRAMES);
+    backtrace_symbols_fd(frames, frames_cnt, fd);
+
+    // Memory map is copied as is - parsing it is left to reader
+    iov = (struct iovec){ .iov_base = "\n# Memory map\n", .iov_len = 14 };
+    __writev_all(fd, &iov, 1);
+    int maps = open("/proc/self/maps", O_RDONLY);
+    if (maps >= 0)
+    {
+        char buf[4096];
+        ssize_t got;
+        while ((got = read(maps, buf, sizeof(buf))) > 0)
+        {
+            iov = (struct iovec){ .iov_base = buf, .iov_len = (size_t)got };
+            if (__writev_all(fd, &iov, 1) != LOG_RES_SUCCESS) { break; }
+        }
+        close(maps);
     }
-    char msg = (char)value;
-    write(__dump_pipe.write, &msg, 1);
+    if (__flight_size != 0) { __flight_crash(fd); }
+    fsync(fd);
+    close(fd);
+    return true;
+}
+
+
+void __crash_tm(time_t _sec, struct tm* _tm)
+{
+    // Civil date from count of days since epoch (proleptic Gregorian calendar)
+    long long local = (long long)_sec + __crash_gmtoff;
+    long long days = local >= 0 ? local / 86400 : (local - 86399) / 86400;
+    long long rem = local - days * 86400;
+    _tm->tm_hour = (int)(rem / 3600);
+    _tm->tm_min = (int)(rem % 3600 / 60);
+    _tm->tm_sec = (int)(rem % 60);
+
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    long long doe = days - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long day = doy - (153 * mp + 2) / 5 + 1;
+    long long month = mp < 10 ? mp + 3 : mp - 9;
+    _tm->tm_year = (int)(yoe + era * 400 + (month <= 2) - 1900);
+    _tm->tm_mon = (int)(month - 1);
+    _tm->tm_mday = (int)day;
 }
@@ -1,6 +1,23 @@
 #pragma once
+#include <signal.h>
+#include <stdbool.h>
 #include <unistd.h>
 
+/**
+ * @brief Most detailed level compiled in (0 - MIN, 1 - STANDARD, 2 - MAX, -1 - none) -
+ *        calls of `log_cat_printf` and `LOG_MIN` / `LOG_STD` / `LOG_MAX` with more detailed
+ *        level are removed at compile time, without evaluating their arguments.
+ *        Define before including header (or pass as compiler flag) to override.
+ */
+#ifndef LOG_COMPILE_LVL
+#define LOG_COMPILE_LVL 2
+#endif
+
+/** @brief Maximum count of log categories, including default one */
+#define LOG_MAX_CATEGORIES ( 64 )
+/** @brief Category used by `log_printf` */
+#define LOG_CATEGORY_DEFAULT ( 0u )
+
 typedef enum
 {
     /** @brief Logging is turned off. Cannot pass as argument to `log_printf` */
@@ -13,24 +30,44 @@ typedef enum
     LOG_LVL_MAX,
 } log_lvl_e;
 
+/** @brief Identifier of log category, returned on its registration */
+typedef unsigned log_category_t;
+
 typedef enum
 {
-    /** @brief Basic DUMP (no options to `pmap`, or `cat /proc/[PID]/maps`
-     *        if `pmap` is not available) */
+    /** @brief Basic DUMP (address, size, permissions and mapping of every region,
+     *        like `pmap`) */
     LOG_DUMP_LVL_NORMAL,
-    /** @brief Detailed DUMP (`pmap -x`, defaults to `LOG_DUMP_LVL_NORMAL`
-     *        if `pmap` is not available) */
+    /** @brief Detailed DUMP (adds resident and dirty size, like `pmap -x`) */
     LOG_DUMP_LVL_DETAIL,
-    /** @brief Extended DUMP (`pmap -X`, defaults to `LOG_DUMP_LVL_NORMAL`
-     *        if `pmap` is not available) */
+    /** @brief Extended DUMP (offset, device, inode and every counter
+     *        of `/proc/[PID]/smaps`, like `pmap -X`) */
     LOG_DUMP_LVL_EXTENDED,
-    /** @brief Full Kernel DUMP (`pmap -XX`, defaults to `LOG_DUMP_LVL_NORMAL`
-     *        if `pmap` is not available) */
+    /** @brief Full Kernel DUMP (adds VmFlags of every region and totals
+     *        of `/proc/[PID]/smaps_rollup`, like `pmap -XX`) */
     LOG_DUMP_LVL_FULL,
 } log_dump_lvl_e;
 
 typedef enum
 {
+    /** @brief Memory map of process */
+    LOG_DUMP_SECTION_MAP = 1,
+    /** @brief Sections written by registered DUMP providers */
+    LOG_DUMP_SECTION_PROVIDERS = 2,
+    /** @brief Latest messages of every thread, captured by flight recorder
+     *        (see `log_config_t::flight_size`) */
+    LOG_DUMP_SECTION_FLIGHT = 4,
+    /** @brief Whole DUMP file (also used when 0 is passed) */
+    LOG_DUMP_SECTION_ALL = 7,
+} log_dump_section_e;
+
+typedef enum
+{
+    /** @brief Message was discarded by rate limit of its call site, or collapsed
+     *        as repeat of previous one (see `log_config_t::rate_limit`) */
+    LOG_RES_SUPPRESSED = -4,
+    /** @brief Message was discarded due to per-thread ring being full (`LOG_MODE_ASYNC` only) */
+    LOG_RES_DROPPED = -3,
     /** @brief Message was discarded due to logging being off */
     LOG_RES_OFF = -2,
     /** @brief Message was discarded due to level higher than current */
@@ -51,21 +88,285 @@ typedef enum
     LOG_RES_ERROR_OTHER = 255,
 } log_res_e;
 
+typedef enum
+{
+    /** @brief Messages are written to LOG file by calling thread, under mutex */
+    LOG_MODE_SYNC,
+    /** @brief Messages are formatted into per-thread lock-free rings,
+     *        and written to LOG file in batches by flusher thread */
+    LOG_MODE_ASYNC,
+    /** @brief LOG file is preallocated and memory-mapped in chunks - calling thread reserves
+     *        space with atomic fetch-add and copies message directly into mapping */
+    LOG_MODE_MMAP,
+} log_mode_e;
+
+typedef enum
+{
+    /** @brief `fsync` after every message (in `LOG_MODE_ASYNC` - after every flusher pass) */
+    LOG_SYNC_MESSAGE,
+    /** @brief `fdatasync` after every message (in `LOG_MODE_ASYNC` - after every flusher pass) */
+    LOG_SYNC_DATA,
+    /** @brief `fsync` after every N messages (N given as policy parameter, default 64) */
+    LOG_SYNC_COUNT,
+    /** @brief `fsync` if at least T milliseconds passed since last one
+     *        (T given as policy parameter, default 1000) */
+    LOG_SYNC_INTERVAL,
+    /** @brief No explicit syncing - left to kernel page cache writeback */
+    LOG_SYNC_NONE,
+} log_sync_e;
+
+typedef enum
+{
+    /** @brief Wall-clock time with second resolution - `YYYY-MM-DD|HH:MM:SS` (default) */
+    LOG_TS_SEC,
+    /** @brief Wall-clock time with millisecond suffix - `YYYY-MM-DD|HH:MM:SS.mmm`
+     *        (resolution of `CLOCK_REALTIME_COARSE`, usually 1-4 ms) */
+    LOG_TS_MSEC,
+    /** @brief Wall-clock time with microsecond suffix - `YYYY-MM-DD|HH:MM:SS.uuuuuu` */
+    LOG_TS_USEC,
+    /** @brief Monotonic time since boot, for latency analysis - `SSSSSS.uuuuuu` */
+    LOG_TS_MONOTONIC,
+} log_ts_e;
+
+typedef enum
+{
+    /** @brief Messages are formatted at call site - `[LVL @ timestamp] message` lines (default) */
+    LOG_FORMAT_TEXT,
+    /** @brief Only format string ID, timestamp and raw arguments are stored at call site -
+     *        LOG file has to be rendered with `log_decode` (`SCR_DECODE` tool) */
+    LOG_FORMAT_BINARY,
+} log_format_e;
+
+typedef enum
+{
+    /** @brief Control signals run asynchronous signal actions, in whichever thread
+     *        receives them (default) */
+    LOG_SIGNALS_ACTION,
+    /** @brief Control signals are blocked in thread calling `log_init` (and in threads
+     *        it creates afterwards, including threads of library), and serviced by control
+     *        thread reading `signalfd` - `log_init` should be called before other threads
+     *        are created. Signals stay blocked after `log_deinit`. */
+    LOG_SIGNALS_THREAD,
+} log_signals_e;
+
+typedef enum
+{
+    /** @brief Structured records are JSON objects, one per line (default) */
+    LOG_KV_JSON,
+    /** @brief Structured records are `key=value` pairs, one record per line */
+    LOG_KV_LOGFMT,
+} log_kv_format_e;
+
+typedef enum
+{
+    LOG_FIELD_INT,
+    LOG_FIELD_UINT,
+    LOG_FIELD_DOUBLE,
+    /** @brief Null-terminated string (`NULL` is written as null) */
+    LOG_FIELD_STR,
+    LOG_FIELD_BOOL,
+    LOG_FIELD_PID,
+    /** @brief Kernel thread ID */
+    LOG_FIELD_TID,
+} log_field_type_e;
+
+/** @brief Typed field of structured record - create with `LOG_INT`, `LOG_STR`, etc. */
+typedef struct
+{
+    /** @brief Name of field - should be plain identifier */
+    const char* key;
+    log_field_type_e type;
+    union
+    {
+        long long i;
+        unsigned long long u;
+        double d;
+        const char* s;
+        bool b;
+    } value;
+} log_field_t;
+
+#define LOG_INT(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_INT, .value.i = (long long)(_value) })
+#define LOG_UINT(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_UINT, .value.u = (unsigned long long)(_value) })
+#define LOG_DOUBLE(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_DOUBLE, .value.d = (double)(_value) })
+#define LOG_STR(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_STR, .value.s = (_value) })
+#define LOG_BOOL(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_BOOL, .value.b = (_value) })
+#define LOG_PID(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_PID, .value.i = (long long)(_value) })
+#define LOG_TID(_key, _value) \
+    ((log_field_t){ .key = (_key), .type = LOG_FIELD_TID, .value.i = (long long)(_value) })
+
+/**
+ * @brief Configuration of logging - zero-initialized fields are replaced with defaults
+ */
+typedef struct
+{
+    /** @brief Mode of writing messages to LOG file (default `LOG_MODE_SYNC`) */
+    log_mode_e mode;
+    /** @brief Capacity in bytes of single per-thread ring used in `LOG_MODE_ASYNC`,
+     *        rounded up to power of 2 (default 64 KiB) */
+    size_t ring_size;
+    /** @brief Maximum time in milliseconds between flusher thread passes
+     *        in `LOG_MODE_ASYNC` (default 10 ms) */
+    unsigned flush_interval_ms;
+    /** @brief Size in bytes of LOG file chunk preallocated and mapped at once
+     *        in `LOG_MODE_MMAP`, rounded up to page size (default 4 MiB) */
+    size_t mmap_chunk;
+    /** @brief Durability policy of LOG file (default `LOG_SYNC_MESSAGE`) -
+     *        in `LOG_MODE_MMAP` applied using `msync` */
+    log_sync_e sync;
+    /** @brief Parameter of `LOG_SYNC_COUNT` and `LOG_SYNC_INTERVAL` policies */
+    unsigned sync_param;
+    /** @brief Format of timestamp in message header (default `LOG_TS_SEC`) */
+    log_ts_e timestamp;
+    /** @brief Maximum size in bytes of single record (header, message and newline) -
+     *        longer messages are truncated and end with ` [TRUNCATED]` marker
+     *        (default 64 KiB, minimum 128 B) */
+    size_t max_record;
+    /** @brief Format of LOG file (default `LOG_FORMAT_TEXT`) */
+    log_format_e format;
+    /** @brief Size in bytes after which new LOG file is started (default 0 - never),
+     *        not supported in `LOG_MODE_MMAP` */
+    size_t rotate_bytes;
+    /** @brief Time in seconds after which new LOG file is started (default 0 - never),
+     *        not supported in `LOG_MODE_MMAP` */
+    unsigned rotate_interval_s;
+    /** @brief Whether rotated LOG files are compressed to `.gz` in background */
+    bool rotate_compress;
+    /** @brief Maximum count of rotated LOG files of process kept in path (default 0 - unlimited) */
+    unsigned retain_segments;
+    /** @brief Maximum total size in bytes of rotated LOG files of process kept in path
+     *        (default 0 - unlimited) */
+    size_t retain_bytes;
+    /** @brief Format of structured records written by `log_fields` (default `LOG_KV_JSON`) */
+    log_kv_format_e kv_format;
+    /** @brief Count of latest records also published to shared-memory tail ring
+     *        (see `log_tail_open`), rounded up to power of 2 - 0 means no ring (default).
+     *        Records longer than 500 B are truncated there. Only `LOG_FORMAT_TEXT` is published. */
+    unsigned tail_records;
+    /** @brief Way control signals (`log_dispatch_*`) are serviced (default `LOG_SIGNALS_ACTION`) */
+    log_signals_e signals;
+    /** @brief Whether LOG file is shared with processes forked after `log_init` - it is neither
+     *        locked nor rotated, and every record (or batch in `LOG_MODE_ASYNC`) is appended
+     *        with single `write`. Not supported with `LOG_MODE_MMAP` and `LOG_FORMAT_BINARY`.
+     *        Otherwise every forked child starts its own LOG file (in `LOG_MODE_MMAP` child
+     *        writes it in `LOG_MODE_SYNC`). Applies to LOG files of instances (see `log_open`)
+     *        too. */
+    bool shared;
+    /** @brief Whether flusher thread of `LOG_MODE_ASYNC` and DUMP thread write through
+     *        io_uring - every batch is single submission of write and linked sync.
+     *        If io_uring is unavailable or fails, `write` and `fsync` are used instead. */
+    bool io_uring;
+    /** @brief Whether fatal signals (`SIGSEGV`, `SIGBUS`, `SIGFPE`, `SIGILL`, `SIGABRT`) are
+     *        caught - on alternate signal stack of every thread that logs, pending messages
+     *        are written and synced, and DUMP file with backtrace and memory map is created,
+     *        before signal is raised again. Crash record in LOG file (`LOG_FORMAT_TEXT` only,
+     *        not in `LOG_MODE_MMAP`) is timestamped using UTC offset from `log_init`. */
+    bool crash_handler;
+    /** @brief Messages per second that single call site (format string) may print in each
+     *        thread - 0 means no limit (default). Count of suppressed messages is printed
+     *        once call site may print again (before its next message, or within 250 ms if
+     *        there is none), when thread exits, and by `log_close` (for instance)
+     *        and `log_deinit` (for all threads) */
+    unsigned rate_limit;
+    /** @brief Messages that call site may print at once, before `rate_limit` applies
+     *        (default `rate_limit`) */
+    unsigned rate_burst;
+    /** @brief Whether message identical to previous one of the same thread is collapsed
+     *        into "Last message repeated N times" - printed when different message comes,
+     *        once a second passed since first of repeats, when thread exits, and by
+     *        `log_close` (for instance) and `log_deinit` (for all threads).
+     *        With `LOG_FORMAT_BINARY`, collapsing applies only to LOG files of `log_t`
+     *        instances (which are always text) - default LOG file is not collapsed */
+    bool collapse_repeats;
+    /** @brief Size in bytes of per-thread flight recorder ring (rounded up to power of 2,
+     *        at least 4 KiB) - 0 means no recorder (default). Messages of every level up to
+     *        `LOG_COMPILE_LVL` are captured as text records, whatever level is current.
+     *        Rings of all threads are written to DUMP file (`LOG_DUMP_SECTION_FLIGHT`)
+     *        and to crash DUMP, and `LOG_LVL_MIN` message orders DUMP of only them
+     *        (at most once per second). Messages of `log_fields` are not captured. */
+    size_t flight_size;
+} log_config_t;
+
+/** @brief Count of buckets of latency histogram - bucket `i` counts samples
+ *         in [2^i, 2^(i+1)) ns, last one also counts all longer samples */
+#define LOG_STATS_BUCKETS ( 32 )
+
+/** @brief Latency histogram of logger operation */
+typedef struct
+{
+    unsigned long long count[LOG_STATS_BUCKETS];
+    /** @brief Sum of all samples in nanoseconds */
+    unsigned long long total_ns;
+} log_stats_hist_t;
+
+/**
+ * @brief Snapshot of self-instrumentation counters, summed over all threads
+ *        since process start
+ */
+typedef struct
+{
+    /** @brief Messages written, queued or copied to LOG file */
+    unsigned long long accepted;
+    /** @brief Messages rejected by level inside library - calls rejected by
+     *        `log_printf` macros at call site never reach library, and are not counted */
+    unsigned long long ignored;
+    /** @brief Messages dropped because ring of calling thread was full */
+    unsigned long long dropped;
+    /** @brief Messages suppressed by rate limit or collapsed as repeats */
+    unsigned long long suppressed;
+    /** @brief Messages lost due to formatting, locking or writing error */
+    unsigned long long failed;
+    /** @brief Bytes of accepted messages */
+    unsigned long long bytes;
+    /** @brief Count of threads that ever logged (including exited ones) */
+    unsigned threads;
+    /** @brief Duration of `write` / `writev` calls on LOG file */
+    log_stats_hist_t write;
+    /** @brief Duration of `fsync`, `fdatasync` or `msync` calls on LOG file */
+    log_stats_hist_t sync;
+    /** @brief Time spent waiting for mutex of LOG file in `LOG_MODE_SYNC` */
+    log_stats_hist_t lock_wait;
+    /** @brief Duration of creating DUMP files - its count is count of DUMP files */
+    log_stats_hist_t dump;
+} log_stats_t;
+
+
+/** @brief Streaming writer passed to DUMP providers */
+typedef struct log_dump_writer log_dump_writer_t;
+
+/**
+ * @brief Callback writing application state to DUMP file, run on its own thread
+ *
+ * @param _writer Writer of section of DUMP file belonging to provider
+ * @param _lvl Level of DUMP detail that was ordered
+ * @param _ctx Context passed on registration
+ */
+typedef void (*log_dump_provider_f)(log_dump_writer_t* _writer, log_dump_lvl_e _lvl, void* _ctx);
 
 /**
  * @brief Initializes resources for logging
  *
  * @param _path Path used to store LOG files - if `NULL`,
  *        then path in which program resides is used.
+ * @param _config Configuration of logging - if `NULL`, then defaults are used
  *
  * @return LOG_RES_SUCCESS - everything OK
  * @return LOG_RES_ERROR_DUP - already initialized, or in process of initializing already
- * @return LOG_RES_ERROR_ARG - _path does not point to existing directory
- * @return LOG_RES_ERROR_FILE - cannot create file in _path
+ * @return LOG_RES_ERROR_ARG - _path does not point to existing directory,
+ *         or _config contains invalid value (or rotation in `LOG_MODE_MMAP`,
+ *         or shared LOG file that is rotated, mapped or binary)
+ * @return LOG_RES_ERROR_FILE - cannot create file in _path, or map it in `LOG_MODE_MMAP`
  * @return LOG_RES_ERROR_SYNC - cannot place lock on LOG file
- * @return LOG_RES_ERROR_PTHREAD - cannot create thread for DUMP
+ * @return LOG_RES_ERROR_PTHREAD - cannot create thread for DUMP, flusher or rotation thread
+ * @return LOG_RES_ERROR_OTHER - cannot allocate resources for `LOG_MODE_ASYNC`
  */
-log_res_e log_init(const char* _path);
+log_res_e log_init(const char* _path, const log_config_t* _config);
 
 /**
  * @brief Cleans resources for logging
@@ -81,9 +382,14 @@ log_res_e log_deinit(void);
  * @param _lvl Level of logged message - if level is lower than current logging
  *        level, (or logging is off) then message is discarded
  * @param _format Format sting of message. For consistency, don't use newline characters!
+ *        Whole record is assembled in memory and written using single system call.
+ *        In `LOG_FORMAT_BINARY`, format string must outlive logging (string literal),
+ *        as its address identifies it - formats using `%n`, `%m`, `%ls` or positional
+ *        arguments are stored preformatted.
  * @param ... Arguments to formatted string
  *
- * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_SUCCESS - everything OK (in `LOG_MODE_ASYNC` - message was queued)
+ * @return LOG_RES_DROPPED - ring of calling thread is full (`LOG_MODE_ASYNC` only)
  * @return LOG_RES_ERROR_FILE - error while writing to file
  * @return LOG_RES_ERROR_SYNC - error while (un)locking mutex
  * @return LOG_RES_ERROR_OTHER - error while printing / formatting message
@@ -92,6 +398,179 @@ log_res_e log_printf(log_lvl_e _lvl, const char* _format, ...)
 __attribute__((format(printf, 2, 3)));
 
 
+/**
+ * @brief Registers named log category, with its own logging level - initially
+ *        same as level of default category
+ *
+ * @param _name Name of category, shown in LOG file (copied, up to 31 characters)
+ * @param _id Identifier of category - if category of same name is already registered,
+ *        its identifier is returned
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _name or _id is `NULL`, or `LOG_MAX_CATEGORIES` are registered
+ */
+log_res_e log_category_register(const char* _name, log_category_t* _id);
+
+/**
+ * @brief Prints formatted message of category `_cat` to LOG file - see `log_printf`
+ *
+ * @param _cat Category of message - compared against level of this category only
+ *
+ * @return LOG_RES_ERROR_ARG - _cat is not registered
+ */
+log_res_e log_category_printf(log_category_t _cat, log_lvl_e _lvl, const char* _format, ...)
+__attribute__((format(printf, 3, 4)));
+
+/** @brief Count of levels enabled for every category (current level + 1) - points into
+ *         control block shared with `SCR_CLI` (see `log_control_open`), read by `log_printf`
+ *         and `log_category_printf` at call site, do not modify */
+extern volatile sig_atomic_t* __log_enabled;
+/** @brief Count of levels captured by flight recorder of every category - 0 if there is
+ *         no recorder, read by `log_printf` macros at call site, do not modify */
+extern volatile sig_atomic_t __log_capture;
+
+/** @brief Result of message rejected at call site (function, so that unused result does not warn) */
+static inline log_res_e __log_rejected(sig_atomic_t _enabled)
+{
+    return _enabled ? LOG_RES_IGNORED : LOG_RES_OFF;
+}
+
+/**
+ * @brief Level is checked at call site, before call is made and before arguments
+ *        are evaluated (so `_lvl` and `_cat` may be evaluated twice).
+ *        Message above `LOG_COMPILE_LVL`, or above current level (unless flight recorder
+ *        captures it), is rejected with `LOG_RES_IGNORED` (or `LOG_RES_OFF` if logging
+ *        is off) without call.
+ *        Use `(log_printf)(...)` to always call function.
+ */
+#define log_printf(_lvl, ...) \
+    (((_lvl) <= LOG_COMPILE_LVL \
+        && __builtin_expect((_lvl) < __log_enabled[LOG_CATEGORY_DEFAULT] \
+            || (_lvl) < __log_capture, 0)) \
+        ? (log_printf)((_lvl), __VA_ARGS__) \
+        : __log_rejected(__log_enabled[LOG_CATEGORY_DEFAULT]))
+
+/** @brief See `log_printf` macro */
+#define log_category_printf(_cat, _lvl, ...) \
+    (((_lvl) <= LOG_COMPILE_LVL && (_cat) < LOG_MAX_CATEGORIES \
+        && __builtin_expect((_lvl) < __log_enabled[(_cat)] || (_lvl) < __log_capture, 0)) \
+        ? (log_category_printf)((_cat), (_lvl), __VA_ARGS__) \
+        : __log_rejected((_cat) < LOG_MAX_CATEGORIES && __log_enabled[(_cat)]))
+
+/**
+ * @brief Prints formatted message of category `_cat`, unless `_lvl` is more detailed
+ *        than `LOG_COMPILE_LVL` - then call is removed at compile time
+ *        (when `_lvl` is constant)
+ */
+#define log_cat_printf(_cat, _lvl, ...) \
+    ((_lvl) <= LOG_COMPILE_LVL \
+        ? log_category_printf((_cat), (_lvl), __VA_ARGS__) \
+        : __log_rejected(1))
+
+#if LOG_COMPILE_LVL >= 0
+#define LOG_MIN(_cat, ...) log_category_printf((_cat), LOG_LVL_MIN, __VA_ARGS__)
+#else
+#define LOG_MIN(_cat, ...) __log_rejected(1)
+#endif
+#if LOG_COMPILE_LVL >= 1
+#define LOG_STD(_cat, ...) log_category_printf((_cat), LOG_LVL_STANDARD, __VA_ARGS__)
+#else
+#define LOG_STD(_cat, ...) __log_rejected(1)
+#endif
+#if LOG_COMPILE_LVL >= 2
+#define LOG_MAX(_cat, ...) log_category_printf((_cat), LOG_LVL_MAX, __VA_ARGS__)
+#else
+#define LOG_MAX(_cat, ...) __log_rejected(1)
+#endif
+
+
+/**
+ * @brief Writes structured record to LOG file, serialized directly (without `printf`)
+ *        as JSON object or logfmt line. Every record holds `time` (see `timestamp`
+ *        of `log_config_t`), `mono_ns` (monotonic clock), `seq` (number of record
+ *        in process), `tid`, `lvl`, `cat` (unless default category), `msg` and `_fields`.
+ *        Fields that do not fit in maximum record size are skipped, and counted in
+ *        `dropped_fields`. In `LOG_FORMAT_BINARY`, line is stored preformatted.
+ *
+ * @param _cat Category of record
+ * @param _lvl Level of record - see `log_printf`
+ * @param _msg Message of record (may be `NULL`)
+ * @param _fields Fields of record
+ * @param _count Count of `_fields`
+ *
+ * @return See `log_category_printf`
+ */
+log_res_e log_fields(log_category_t _cat, log_lvl_e _lvl, const char* _msg,
+    const log_field_t* _fields, size_t _count);
+
+/**
+ * @brief Writes structured record with fields given as arguments (at least one),
+ *        checking level at call site - see `log_printf` macro, e.g.
+ *        `log_kv(LOG_CATEGORY_DEFAULT, LOG_LVL_MIN, "accepted", LOG_INT("fd", fd), LOG_STR("peer", peer))`
+ */
+#define log_kv(_cat, _lvl, _msg, ...) \
+    (((_lvl) <= LOG_COMPILE_LVL && (_cat) < LOG_MAX_CATEGORIES \
+        && __builtin_expect((_lvl) < __log_enabled[(_cat)], 0)) \
+        ? log_fields((_cat), (_lvl), (_msg), (const log_field_t[]){ __VA_ARGS__ }, \
+            sizeof((const log_field_t[]){ __VA_ARGS__ }) / sizeof(log_field_t)) \
+        : __log_rejected((_cat) < LOG_MAX_CATEGORIES && __log_enabled[(_cat)]))
+
+
+/** @brief Logger instance - LOG file with its own mutex, see `log_open` */
+typedef struct log log_t;
+
+/**
+ * @brief Opens logger instance - separate LOG file `pid${PID}_${_name}_${timestamp}.LOG`
+ *        in path of `log_init`, written synchronously under its own mutex, so that
+ *        subsystems logging to different instances never contend with each other,
+ *        or with default LOG file. Records are formatted like in default LOG file
+ *        (always as text), and filtered by same category levels - control signals and
+ *        control block apply to every instance. DUMP, rotation and tail ring
+ *        belong to default LOG file only. Instance stays usable after `log_deinit`,
+ *        until it is closed.
+ *
+ * @param _name Name of instance - letters, digits, `-` and `_`, starting with letter
+ *        (up to 15 characters)
+ * @param _config Only `sync` and `sync_param` are used - if `NULL`, then defaults are used
+ * @param _log Opened instance
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_DUP - logging is not initialized
+ * @return LOG_RES_ERROR_ARG - _name, _config or _log is invalid
+ * @return LOG_RES_ERROR_FILE - cannot create LOG file of instance
+ * @return LOG_RES_ERROR_OTHER - cannot allocate instance
+ */
+log_res_e log_open(const char* _name, const log_config_t* _config, log_t** _log);
+
+/**
+ * @brief Closes logger instance opened by `log_open` - no thread may use it anymore
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _log is `NULL` or default instance
+ */
+log_res_e log_close(log_t* _log);
+
+/** @brief Default instance - LOG file of `log_init`, written by `log_printf` and others */
+log_t* log_default(void);
+
+/**
+ * @brief Prints formatted message of category `_cat` to LOG file of instance `_log` -
+ *        see `log_category_printf`
+ *
+ * @return LOG_RES_ERROR_ARG - _log is `NULL`, or _cat is not registered
+ */
+log_res_e log_instance_printf(log_t* _log, log_category_t _cat, log_lvl_e _lvl,
+    const char* _format, ...)
+__attribute__((format(printf, 4, 5)));
+
+/** @brief See `log_printf` macro */
+#define log_instance_printf(_log, _cat, _lvl, ...) \
+    (((_lvl) <= LOG_COMPILE_LVL && (_cat) < LOG_MAX_CATEGORIES \
+        && __builtin_expect((_lvl) < __log_enabled[(_cat)] || (_lvl) < __log_capture, 0)) \
+        ? (log_instance_printf)((_log), (_cat), (_lvl), __VA_ARGS__) \
+        : __log_rejected((_cat) < LOG_MAX_CATEGORIES && __log_enabled[(_cat)]))
+
+
 /**
  * @brief Changes logging level, by sending signal using sigqueue
  * 
@@ -105,6 +584,20 @@ __attribute__((format(printf, 2, 3)));
  */
 log_res_e log_dispatch_log_level(pid_t _pid, log_lvl_e _lvl);
 
+/**
+ * @brief Changes logging level of single category, by sending signal using sigqueue
+ *
+ * @param _pid ID of process that should have logging level changed - if 0,
+ *        then current process receives signal
+ * @param _cat Identifier of category in process _pid
+ * @param _lvl New logging level of category
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _cat or _lvl is invalid
+ * @return LOG_RES_ERROR_SYNC - cannot send signal
+ */
+log_res_e log_dispatch_category_level(pid_t _pid, log_category_t _cat, log_lvl_e _lvl);
+
 /**
  * @brief Dumps process memory map, by sending signal using sigqueue
  *
@@ -117,3 +610,215 @@ log_res_e log_dispatch_log_level(pid_t _pid, log_lvl_e _lvl);
  * @return LOG_RES_ERROR_SYNC - cannot send signal
  */
 log_res_e log_dispatch_log_dump(pid_t _pid, log_dump_lvl_e _lvl);
+
+/**
+ * @brief Dumps chosen sections of process state, by sending signal using sigqueue.
+ *        Orders of same level and sections, sent before DUMP thread picks up
+ *        previous one, are merged into single DUMP file.
+ *
+ * @param _pid ID of process that should have state dumped - if 0,
+ *        then current process receives signal
+ * @param _lvl Level of DUMP detail
+ * @param _sections Bitwise OR of `log_dump_section_e` - if 0, then whole DUMP is written
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _lvl or _sections is invalid
+ * @return LOG_RES_ERROR_SYNC - cannot send signal
+ */
+log_res_e log_dispatch_log_dump_sections(pid_t _pid, log_dump_lvl_e _lvl, unsigned _sections);
+
+/**
+ * @brief Changes durability policy of LOG file, by sending signal using sigqueue
+ *
+ * @param _pid ID of process that should have policy changed - if 0,
+ *        then current process receives signal
+ * @param _sync New durability policy
+ * @param _param Parameter of `LOG_SYNC_COUNT` or `LOG_SYNC_INTERVAL` policy -
+ *        if 0, then default is used (must be lower than 2^27)
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _sync or _param is invalid
+ * @return LOG_RES_ERROR_SYNC - cannot send signal
+ */
+log_res_e log_dispatch_sync_policy(pid_t _pid, log_sync_e _sync, unsigned _param);
+
+/**
+ * @brief Orders snapshot of self-instrumentation counters, by sending signal using sigqueue.
+ *        Snapshot is written to `.STATS` file next to LOG file of process.
+ *
+ * @param _pid ID of process that should write snapshot - if 0,
+ *        then current process receives signal
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_SYNC - cannot send signal
+ */
+log_res_e log_dispatch_stats(pid_t _pid);
+
+/**
+ * @brief Sums self-instrumentation counters of all threads - works also
+ *        when library is not initialized
+ *
+ * @param _stats Snapshot to fill - counters of running threads are read
+ *        without stopping them, so they may be slightly out of step
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _stats is `NULL`
+ */
+log_res_e log_stats(log_stats_t* _stats);
+
+/** @brief Handle of control block of another process - see `log_control_open` */
+typedef struct log_control log_control_t;
+
+/**
+ * @brief Maps control block of process - POSIX shared memory holding its LOG levels,
+ *        durability policy and rotation settings, that logger reads without syscalls.
+ *        Changes made through handle apply immediately - signal is used only
+ *        as doorbell, so that process records them (see `log_control_close`).
+ *
+ * @param _pid ID of process with initialized logging - if 0, then current process
+ * @param _ctl Created handle
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _ctl is `NULL`, or process has no control block
+ *         (logging is not initialized, or its version differs)
+ * @return LOG_RES_ERROR_FILE - control block cannot be opened or mapped
+ * @return LOG_RES_ERROR_OTHER - cannot allocate handle
+ */
+log_res_e log_control_open(pid_t _pid, log_control_t** _ctl);
+
+/**
+ * @brief Changes logging level through control block
+ *
+ * @param _cat Identifier of category - if `LOG_MAX_CATEGORIES`, then every category
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _ctl, _cat or _lvl is invalid
+ */
+log_res_e log_control_level(log_control_t* _ctl, log_category_t _cat, log_lvl_e _lvl);
+
+/**
+ * @brief Changes durability policy through control block - see `log_dispatch_sync_policy`
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _ctl, _sync or _param is invalid
+ */
+log_res_e log_control_sync(log_control_t* _ctl, log_sync_e _sync, unsigned _param);
+
+/**
+ * @brief Changes rotation settings through control block - see `log_config_t`.
+ *        Ignored by processes in `LOG_MODE_MMAP`.
+ *
+ * @param _bytes Size in bytes after which new LOG file is started (0 - never)
+ * @param _interval_s Time in seconds after which new LOG file is started (0 - never)
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _ctl is `NULL`
+ */
+log_res_e log_control_rotation(log_control_t* _ctl, size_t _bytes, unsigned _interval_s);
+
+/**
+ * @brief Unmaps control block and frees handle - if anything was changed,
+ *        then process is notified by sending signal using sigqueue
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _ctl is `NULL`
+ * @return LOG_RES_ERROR_SYNC - cannot send signal (changes still apply)
+ */
+log_res_e log_control_close(log_control_t* _ctl);
+
+/** @brief Reader of shared-memory tail ring of another process - see `log_tail_open` */
+typedef struct log_tail log_tail_t;
+
+/**
+ * @brief Attaches to tail ring of process (`log_config_t.tail_records`), without
+ *        touching its LOG file. Readers never slow process down - records
+ *        overwritten before being read are reported as missed.
+ *
+ * @param _pid ID of process with initialized logging - if 0, then current process
+ * @param _backlog Count of already published records to start with
+ * @param _tail Created reader
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _tail is `NULL`, or process has no tail ring
+ * @return LOG_RES_ERROR_FILE - tail ring cannot be opened or mapped
+ * @return LOG_RES_ERROR_OTHER - cannot allocate reader
+ */
+log_res_e log_tail_open(pid_t _pid, unsigned _backlog, log_tail_t** _tail);
+
+/**
+ * @brief Copies next record of tail ring, without blocking
+ *
+ * @param _buf Buffer for record - longer records are truncated
+ * @param _cap Size of _buf
+ * @param _len Length of copied record - 0 if no new record was published yet
+ * @param _missed Count of records overwritten (or abandoned by their writer)
+ *        since previous call, that were skipped
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _tail, _buf, _len or _missed is `NULL`
+ */
+log_res_e log_tail_next(log_tail_t* _tail, char* _buf, size_t _cap, size_t* _len,
+    unsigned long long* _missed);
+
+/**
+ * @brief Detaches from tail ring and frees reader
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _tail is `NULL`
+ */
+log_res_e log_tail_close(log_tail_t* _tail);
+
+/**
+ * @brief Renders binary LOG file (`LOG_FORMAT_BINARY`) as text LOG file
+ *
+ * @param _in_fd Binary LOG file - must support `mmap`
+ * @param _out_fd File that text lines are written to
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _in_fd is not binary LOG file
+ * @return LOG_RES_ERROR_FILE - error while reading or writing file
+ * @return LOG_RES_ERROR_OTHER - cannot allocate memory for decoding
+ */
+log_res_e log_decode(int _in_fd, int _out_fd);
+
+/**
+ * @brief Registers DUMP provider, invoked for every DUMP after memory map is written
+ *
+ * @param _name Name of provider, heading its section of DUMP file (copied)
+ * @param _provider Callback writing section - runs on its own thread, concurrently
+ *        with other providers and the application
+ * @param _ctx Context passed to `_provider`
+ * @param _priority Providers with higher priority are written to DUMP file first
+ * @param _timeout_ms Time after which output of provider is abandoned, and DUMP file
+ *        is completed without it - if 0, then default (100 ms) is used.
+ *        Provider still running from previous DUMP is skipped.
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - _name or _provider is `NULL`, or too many providers
+ * @return LOG_RES_ERROR_DUP - provider of same name is already registered
+ */
+log_res_e log_dump_register(const char* _name, log_dump_provider_f _provider, void* _ctx,
+    int _priority, unsigned _timeout_ms);
+
+/**
+ * @brief Unregisters DUMP provider - provider running for DUMP in progress is not waited for,
+ *        so its context must stay valid until it returns
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_ARG - no provider of _name is registered
+ */
+log_res_e log_dump_unregister(const char* _name);
+
+/**
+ * @brief Writes `_len` bytes of `_data` to section of DUMP provider
+ *
+ * @return LOG_RES_SUCCESS - everything OK
+ * @return LOG_RES_ERROR_OTHER - section exceeded its limit (1 MiB), and was truncated
+ */
+log_res_e log_dump_write(log_dump_writer_t* _writer, const void* _data, size_t _len);
+
+/**
+ * @brief Writes formatted text to section of DUMP provider - see `log_dump_write`
+ */
+log_res_e log_dump_printf(log_dump_writer_t* _writer, const char* _format, ...)
+__attribute__((format(printf, 2, 3)));
@@ -8,8 +8,12 @@
 #include "logger.h"
 
 volatile sig_atomic_t is_running = false;
+/** @brief State of computation, written to DUMP file */
+volatile long fib_iteration = 0;
+volatile long fib_current = 0;
 
 void finalize_handler(int _signal);
+void fibonacci_dump(log_dump_writer_t* _writer, log_dump_lvl_e _lvl, void* _ctx);
 
 int main(int argc, char const* argv[])
 {
@@ -27,7 +31,8 @@ int main(int argc, char const* argv[])
     sigprocmask(SIG_BLOCK, &mask, NULL);
 
 
-    log_init(NULL);
+    log_init(NULL, NULL);
+    log_dump_register("fibonacci", fibonacci_dump, NULL, 0, 0);
 
     is_running = true;
 
@@ -36,6 +41,8 @@ int main(int argc, char const* argv[])
         (f_2 = f_1), (f_1 = f_c), (f_c = f_1 + f_2))
     {
         printf("Fibonacci iteration: %ld + %ld = %ld\n", f_2, f_1, f_c);
+        ++fib_iteration;
+        fib_current = f_c;
 
         log_printf(LOG_LVL_MIN, "f current  = %ld", f_c);
         log_printf(LOG_LVL_STANDARD, "f[-1] = %ld", f_1);
@@ -44,6 +51,7 @@ int main(int argc, char const* argv[])
         sleep(3);
     }
 
+    log_dump_unregister("fibonacci");
     log_deinit();
     
     printf("\nFinished terminating program. Waiting for input...");
@@ -56,3 +64,9 @@ void finalize_handler(int _signal)
 {
     is_running = false;
 }
+
+void fibonacci_dump(log_dump_writer_t* _writer, log_dump_lvl_e _lvl, void* _ctx)
+{
+    log_dump_printf(_writer, "iteration: %ld\n", fib_iteration);
+    log_dump_printf(_writer, "current:   %ld\n", fib_current);
+}